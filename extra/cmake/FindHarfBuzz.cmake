@@ -29,6 +29,7 @@
 # After successful discovery, this will set for inclusion where needed:
 # HARFBUZZ_INCLUDE_DIRS - containg the HarfBuzz headers
 # HARFBUZZ_LIBRARIES - containg the HarfBuzz library
+# HARFBUZZ_SUBSET_LIBRARIES - containg the HarfBuzz subsetter library
 
 INCLUDE(FindPkgConfig)
 
@@ -42,5 +43,9 @@ FIND_LIBRARY(HARFBUZZ_LIBRARIES NAMES harfbuzz
   HINTS ${PC_HARFBUZZ_LIBRARY_DIRS} ${PC_HARFBUZZ_LIBDIR}
 )
 
+FIND_LIBRARY(HARFBUZZ_SUBSET_LIBRARIES NAMES harfbuzz-subset
+  HINTS ${PC_HARFBUZZ_LIBRARY_DIRS} ${PC_HARFBUZZ_LIBDIR}
+)
+
 INCLUDE(FindPackageHandleStandardArgs)
-FIND_PACKAGE_HANDLE_STANDARD_ARGS(HarfBuzz DEFAULT_MSG HARFBUZZ_INCLUDE_DIRS HARFBUZZ_LIBRARIES)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(HarfBuzz DEFAULT_MSG HARFBUZZ_INCLUDE_DIRS HARFBUZZ_LIBRARIES HARFBUZZ_SUBSET_LIBRARIES)
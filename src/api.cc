@@ -13,6 +13,7 @@
  */
 #include "api.h"
 #include "context.h"
+#include "data.h"
 #include "eval.h"
 
 #include <iostream>
@@ -22,14 +23,27 @@ using namespace std::placeholders;
 using namespace clip;
 
 struct clip_s {
+  Context context;
   OutputFormat format;
   std::string buffer;
+  bool buffer_valid;
   ReturnCode error;
+  ProgramParams params;
+};
+
+struct clip_template_s {
+  Program program;
 };
 
 clip_t* clip_init() {
   auto ctx = std::make_unique<clip_t>();
   ctx->format = OutputFormat::SVG;
+  ctx->buffer_valid = false;
+
+  if (auto rc = context_setup_defaults(&ctx->context); !rc) {
+    ctx->error = rc;
+  }
+
   return ctx.release();
 }
 
@@ -46,28 +60,102 @@ void clip_set_error(clip_t* ctx, const ReturnCode& err) {
 }
 
 int clip_eval(clip_t* ctx, const char* expr) {
-  //Context ctx;
-  //auto rc = clip::eval(ctx, expr);
-  //clip_set_error(ctx, rc);
-  //return rc;
+  ctx->buffer_valid = false;
+
+  if (auto rc = eval(&ctx->context, std::string(expr)); !rc) {
+    clip_set_error(ctx, rc);
+    return ERROR;
+  }
+
   return OK;
 }
 
-void clip_get_result(clip_t* ctx, const void** data, size_t* data_len) {
+void clip_reset(clip_t* ctx) {
+  context_reset(&ctx->context);
+  ctx->buffer.clear();
+  ctx->buffer_valid = false;
+}
+
+int clip_get_result(clip_t* ctx, const void** data, size_t* data_len) {
+  if (!ctx->buffer_valid) {
+    if (auto rc = eval_export(&ctx->context, ctx->format, &ctx->buffer); !rc) {
+      ctx->buffer.clear();
+      clip_set_error(ctx, rc);
+      return ERROR;
+    }
+
+    ctx->buffer_valid = true;
+  }
+
   *data = ctx->buffer.data();
   *data_len = ctx->buffer.size();
+  return OK;
+}
+
+int clip_render_to(clip_t* ctx, clip_write_fn write, void* user) {
+  auto rc = eval_export(
+      &ctx->context,
+      ctx->format,
+      [write, user] (const char* data, size_t size) {
+        if (!write(data, size, user)) {
+          return error(ERROR, "write aborted by the callback");
+        }
+
+        return ReturnCode(OK);
+      });
+
+  if (!rc) {
+    clip_set_error(ctx, rc);
+    return ERROR;
+  }
+
+  return OK;
+}
+
+void clip_bind_column(
+    clip_t* ctx,
+    const char* name,
+    const double* data,
+    size_t data_len) {
+  data_bind_column(&ctx->context, name, ColumnType::FLOAT64, data, data_len);
+}
+
+void clip_bind_column_int64(
+    clip_t* ctx,
+    const char* name,
+    const int64_t* data,
+    size_t data_len) {
+  data_bind_column(&ctx->context, name, ColumnType::INT64, data, data_len);
 }
 
-int clip_set_output_format(clip_t* ctx, const char* path, const char* fmt) {
+void clip_bind_column_string(
+    clip_t* ctx,
+    const char* name,
+    const char* const* data,
+    size_t data_len) {
+  data_bind_column(&ctx->context, name, ColumnType::STRING, data, data_len);
+}
+
+void clip_bind_column_timestamp(
+    clip_t* ctx,
+    const char* name,
+    const int64_t* data,
+    size_t data_len) {
+  data_bind_column(&ctx->context, name, ColumnType::TIMESTAMP, data, data_len);
+}
+
+int clip_set_output_format(clip_t* ctx, const char* fmt) {
   std::string format = fmt;
 
   if (format == "svg") {
     ctx->format = OutputFormat::SVG;
+    ctx->buffer_valid = false;
     return OK;
   }
 
   if (format == "png") {
     ctx->format = OutputFormat::PNG;
+    ctx->buffer_valid = false;
     return OK;
   }
 
@@ -75,3 +163,39 @@ int clip_set_output_format(clip_t* ctx, const char* path, const char* fmt) {
   return ERROR;
 }
 
+clip_template_t* clip_compile(clip_t* ctx, const char* expr) {
+  auto tpl = std::make_unique<clip_template_t>();
+  if (auto rc = program_compile_template(expr, &tpl->program); !rc) {
+    clip_set_error(ctx, rc);
+    return nullptr;
+  }
+
+  return tpl.release();
+}
+
+void clip_template_destroy(clip_template_t* tpl) {
+  delete tpl;
+}
+
+void clip_set_param(clip_t* ctx, const char* name, const char* value) {
+  ctx->params[name] = value;
+}
+
+void clip_clear_params(clip_t* ctx) {
+  ctx->params.clear();
+}
+
+int clip_eval_template(clip_t* ctx, const clip_template_t* tpl) {
+  // bound columns are the inputs of the template and survive the reset
+  auto columns = std::move(ctx->context.columns);
+  context_reset(&ctx->context);
+  ctx->context.columns = std::move(columns);
+  ctx->buffer_valid = false;
+
+  if (auto rc = eval(&ctx->context, tpl->program, ctx->params); !rc) {
+    clip_set_error(ctx, rc);
+    return ERROR;
+  }
+
+  return OK;
+}
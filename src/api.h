@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #pragma once
+#include <stdint.h>
 #include <stdlib.h>
 
 /**
@@ -24,9 +25,19 @@ extern "C" {
 #define CLIP_API __attribute__((visibility ("default")))
 
 typedef struct clip_s clip_t;
+typedef struct clip_template_s clip_template_t;
 
 /**
- * Initialize a new clip context.
+ * Output callback for `clip_render_to`. Must return one (1) to continue or
+ * zero (0) to abort rendering.
+ */
+typedef int (*clip_write_fn)(const void* data, size_t data_len, void* user);
+
+/**
+ * Initialize a new clip context. The context loads the default fonts once and
+ * keeps them for its whole lifetime, so a single context should be reused to
+ * render many charts. If loading the fonts failed, the error can be retrieved
+ * using `clip_get_error`.
  *
  * @returns: A clip context that must be free'd using `clip_destroy`
  */
@@ -47,7 +58,9 @@ CLIP_API
 const char* clip_get_error(const clip_t* ctx);
 
 /**
- * Evaluate an clip expression
+ * Evaluate an clip expression. The rendered chart can be retrieved using
+ * `clip_get_result` or `clip_render_to`. Subsequent calls add to the same chart
+ * until `clip_reset` is called.
  *
  * @returns: One (1) on success and zero (0) if an error has occured
  */
@@ -55,16 +68,128 @@ CLIP_API
 int clip_eval(clip_t* ctx, const char* expr);
 
 /**
- * Retrieve the result. Pointer is valid until the next call to clip_eval
+ * Clear the current chart and reset all document settings to their defaults.
+ * Loaded fonts and caches are kept for the next chart.
+ */
+CLIP_API
+void clip_reset(clip_t* ctx);
+
+/**
+ * Render the current chart and retrieve the result. The pointer is valid until
+ * the next call to clip_eval
+ *
+ * @returns: One (1) on success and zero (0) if an error has occured
+ */
+CLIP_API
+int clip_get_result(clip_t* ctx, const void** data, size_t* data_len);
+
+/**
+ * Render the current chart and pass the output to the `write` callback in
+ * chunks as it is produced instead of building the whole output in memory.
+ * The `user` pointer is passed to every call of the callback.
+ *
+ * @returns: One (1) on success and zero (0) if an error has occured or the
+ *   callback aborted rendering
+ */
+CLIP_API
+int clip_render_to(clip_t* ctx, clip_write_fn write, void* user);
+
+/**
+ * Bind an array of values to a column name. The column can be referenced from
+ * expressions using `(column <name>)`, for example `data-x (column mydata)`.
+ *
+ * The data is not copied, so the array must remain valid until `clip_reset`
+ * or `clip_destroy` is called. Binding a column with the same name again
+ * replaces the previous column.
+ */
+CLIP_API
+void clip_bind_column(
+    clip_t* ctx,
+    const char* name,
+    const double* data,
+    size_t data_len);
+
+/**
+ * Bind an array of integers to a column name. See `clip_bind_column`
+ */
+CLIP_API
+void clip_bind_column_int64(
+    clip_t* ctx,
+    const char* name,
+    const int64_t* data,
+    size_t data_len);
+
+/**
+ * Bind an array of null-terminated strings to a column name. See
+ * `clip_bind_column`
+ */
+CLIP_API
+void clip_bind_column_string(
+    clip_t* ctx,
+    const char* name,
+    const char* const* data,
+    size_t data_len);
+
+/**
+ * Bind an array of timestamps, given in microseconds since the unix epoch, to a
+ * column name. See `clip_bind_column`
+ */
+CLIP_API
+void clip_bind_column_timestamp(
+    clip_t* ctx,
+    const char* name,
+    const int64_t* data,
+    size_t data_len);
+
+/**
+ * Set the output format. Valid values are 'svg' and 'png'
+ *
+ * @returns: One (1) on success and zero (0) if an error has occured
+ */
+CLIP_API
+int clip_set_output_format(clip_t* ctx, const char* format);
+
+/**
+ * Compile an clip expression into a template. A template is parsed and
+ * validated once and may then be evaluated any number of times using
+ * `clip_eval_template`. Unquoted values of the form `$name` in the expression
+ * are parameter slots that are filled in using `clip_set_param`.
+ *
+ * @returns: A template that must be free'd using `clip_template_destroy` or
+ *   NULL if an error has occured
+ */
+CLIP_API
+clip_template_t* clip_compile(clip_t* ctx, const char* expr);
+
+/**
+ * Free a template
+ */
+CLIP_API
+void clip_template_destroy(clip_template_t* tpl);
+
+/**
+ * Bind a value to a template parameter slot. The value is used by all
+ * subsequent calls to `clip_eval_template` until it is changed or cleared.
  */
 CLIP_API
-void clip_get_result(clip_t* ctx, const void** data, size_t* data_len);
+void clip_set_param(clip_t* ctx, const char* name, const char* value);
 
 /**
- * Set the output format
+ * Clear all template parameter values
+ */
+CLIP_API
+void clip_clear_params(clip_t* ctx);
+
+/**
+ * Evaluate a template using the currently bound parameter values. The current
+ * chart is cleared before the template is evaluated, as if `clip_reset` was
+ * called, but bound columns are kept. The rendered chart can be retrieved using
+ * `clip_get_result` or `clip_render_to`
+ *
+ * @returns: One (1) on success and zero (0) if an error has occured
  */
 CLIP_API
-void clip_set_output_format(clip_t* ctx, const char* format);
+int clip_eval_template(clip_t* ctx, const clip_template_t* tpl);
 
 
 #ifdef __cplusplus
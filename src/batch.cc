@@ -0,0 +1,160 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "batch.h"
+#include "data.h"
+#include "utils/fileutil.h"
+#include "utils/stringutil.h"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+namespace clip {
+
+BatchConfig::BatchConfig() :
+    worker_count(std::max(std::thread::hardware_concurrency(), 1u)),
+    font_defaults(true) {}
+
+ReturnCode batch_read_manifest(
+    const std::string& path,
+    std::vector<BatchJob>* jobs) {
+  std::string manifest;
+  if (auto rc = read_file(path, &manifest); !rc) {
+    return rc;
+  }
+
+  auto lines = StringUtil::split(manifest, "\n");
+  for (size_t line_idx = 0; line_idx < lines.size(); ++line_idx) {
+    std::vector<std::string> fields;
+    std::istringstream line(lines[line_idx]);
+    for (std::string field; line >> field; ) {
+      fields.emplace_back(field);
+    }
+
+    if (fields.empty() || StringUtil::beginsWith(fields[0], "#")) {
+      continue;
+    }
+
+    if (fields.size() < 2) {
+      return errorf(
+          ERROR,
+          "{}:{}: invalid batch job; expected: <input> <output> [<param>...]",
+          path,
+          line_idx + 1);
+    }
+
+    BatchJob job;
+    job.input_path = fields[0];
+    job.output_path = fields[1];
+    job.output_format = StringUtil::endsWith(job.output_path, ".png") ?
+        OutputFormat::PNG :
+        OutputFormat::SVG;
+
+    for (size_t i = 2; i < fields.size(); ++i) {
+      if (auto rc = program_bind_param(fields[i], &job.params); !rc) {
+        return errorf(ERROR, "{}:{}: {}", path, line_idx + 1, rc.message);
+      }
+    }
+
+    jobs->emplace_back(std::move(job));
+  }
+
+  return OK;
+}
+
+ReturnCode batch_render(
+    const FontInfo& font,
+    const std::shared_ptr<DataCache>& data_cache,
+    const BatchJob& job) {
+  std::string input;
+  if (auto rc = read_file(job.input_path, &input); !rc) {
+    return rc;
+  }
+
+  // jobs with parameters are rendered from a template
+  Program program;
+  auto program_rc = job.params.empty() ?
+      program_compile(input, &program) :
+      program_compile_template(input, &program);
+
+  if (!program_rc) {
+    return program_rc;
+  }
+
+  Context ctx;
+  ctx.font = font;
+  ctx.data_cache = data_cache;
+
+  if (auto rc = eval(&ctx, program, job.params); !rc) {
+    return rc;
+  }
+
+  std::string output;
+  if (auto rc = eval_export(&ctx, job.output_format, &output); !rc) {
+    return rc;
+  }
+
+  return write_file(job.output_path, output);
+}
+
+ReturnCode batch_run(
+    const BatchConfig& config,
+    std::vector<ReturnCode>* results) {
+  auto worker_count = std::min(
+      std::max(config.worker_count, size_t(1)),
+      std::max(config.jobs.size(), size_t(1)));
+
+  FontInfo font;
+  {
+    Context ctx;
+    ctx.font_defaults = config.font_defaults;
+    ctx.font_load = config.font_load;
+
+    if (auto rc = context_setup_defaults(&ctx); !rc) {
+      return rc;
+    }
+
+    font = ctx.font;
+  }
+
+  auto data_cache = std::make_shared<DataCache>();
+  results->clear();
+  results->resize(config.jobs.size());
+
+  std::atomic<size_t> job_next(0);
+  auto work = [&] () {
+    for (;;) {
+      auto job_idx = job_next++;
+      if (job_idx >= config.jobs.size()) {
+        return;
+      }
+
+      (*results)[job_idx] = batch_render(font, data_cache, config.jobs[job_idx]);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers.emplace_back(work);
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  return OK;
+}
+
+} // namespace clip
+
@@ -0,0 +1,59 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include "eval.h"
+#include "return_code.h"
+
+namespace clip {
+
+struct BatchJob {
+  std::string input_path;
+  std::string output_path;
+  OutputFormat output_format;
+  ProgramParams params;
+};
+
+struct BatchConfig {
+  BatchConfig();
+
+  std::vector<BatchJob> jobs;
+  size_t worker_count;
+
+  bool font_defaults;
+  std::vector<std::string> font_load;
+};
+
+/**
+ * Read a batch manifest. Each non-empty line of the manifest describes one job
+ * and has the form `<input> <output> [<name>=<value>...]`. Lines starting with
+ * `#` are ignored.
+ */
+ReturnCode batch_read_manifest(
+    const std::string& path,
+    std::vector<BatchJob>* jobs);
+
+/**
+ * Render all jobs of a batch on a pool of worker threads. The fonts are loaded
+ * once for all workers and data files that are referenced by more than one job are
+ * only parsed once. A failing job does not abort the batch; the result of each
+ * job is stored in `results`.
+ */
+ReturnCode batch_run(
+    const BatchConfig& config,
+    std::vector<ReturnCode>* results);
+
+} // namespace clip
+
@@ -25,6 +25,9 @@
 #include "graphics/export_svg.h"
 #include "eval.h"
 #include "fileutil.h"
+#include "server.h"
+#include "batch.h"
+#include "watch.h"
 
 using namespace clip;
 
@@ -38,6 +41,12 @@ int main(int argc, const char** argv) {
   std::string flag_in;
   flag_parser.defineString("in", false, &flag_in);
 
+  std::string flag_template;
+  flag_parser.defineString("template", false, &flag_template);
+
+  std::vector<std::string> flag_params;
+  flag_parser.defineStringV("param", &flag_params);
+
   std::string flag_out;
   flag_parser.defineString("out", false, &flag_out);
 
@@ -50,6 +59,18 @@ int main(int argc, const char** argv) {
   std::string flag_format;
   flag_parser.defineString("format", false, &flag_format);
 
+  std::string flag_batch;
+  flag_parser.defineString("batch", false, &flag_batch);
+
+  std::string flag_serve;
+  flag_parser.defineString("serve", false, &flag_serve);
+
+  uint64_t flag_workers = 0;
+  flag_parser.defineUInt64("workers", false, &flag_workers);
+
+  bool flag_watch = false;
+  flag_parser.defineSwitch("watch", &flag_watch);
+
   bool flag_help = false;
   flag_parser.defineSwitch("help", &flag_help);
 
@@ -89,6 +110,8 @@ int main(int argc, const char** argv) {
     std::cerr <<
         "Usage: $ clip [OPTIONS]\n"
         "  --in <path>               Path to the input file\n"
+        "  --template <path>         Path to an input file containing parameter slots ($name)\n"
+        "  --param <name>=<value>    Bind a value to a template parameter slot\n"
         "  --out <path>              Path to the output file\n"
         "  --stdin                   Read the input file from stdin\n"
         "  --stdout                  Write the output file from sdout\n"
@@ -97,17 +120,108 @@ int main(int argc, const char** argv) {
         "  --font-defaults <bool>    Enable or disable default font loading. Default is enabled.\n"
         "                            Valid values: 'on' and 'off'\n"
         "  --font-load <path>        Add a font file to the default font list\n"
+        "  --watch                   Re-render the output file when the input or data files change\n"
+        "  --batch <path>            Render all jobs listed in a batch manifest file\n"
+        "  --serve <path>            Run a render server on the given unix socket\n"
+        "  --workers <count>         Number of batch or server workers. Default is one per core.\n"
         "  --debug                   Run in debug mode\n"
         "  --help                    Display this help text and exit\n"
         "  --version                 Display the version of this binary and exit\n"
         "\n"
         "Examples:\n"
-        "  $ clip --in my_chart.clp --out my_chart.svg\n";
+        "  $ clip --in my_chart.clp --out my_chart.svg\n"
+        "  $ clip --template my_chart.clp --param data=my_data.csv --out my_chart.svg\n"
+        "  $ clip --in my_chart.clp --out my_chart.svg --watch\n"
+        "  $ clip --batch manifest.txt --workers 8\n"
+        "  $ clip --serve /tmp/clip.sock --workers 4\n";
 
     return 0;
   }
 
+  /* run a batch */
+  if (!flag_batch.empty()) {
+    BatchConfig batch_config;
+    batch_config.font_defaults = flag_font_defaults;
+    batch_config.font_load = flag_font_load;
+
+    if (flag_workers > 0) {
+      batch_config.worker_count = flag_workers;
+    }
+
+    if (auto rc = batch_read_manifest(flag_batch, &batch_config.jobs); !rc) {
+      error_print(rc, std::cerr);
+      return EXIT_FAILURE;
+    }
+
+    std::vector<ReturnCode> batch_results;
+    if (auto rc = batch_run(batch_config, &batch_results); !rc) {
+      error_print(rc, std::cerr);
+      return EXIT_FAILURE;
+    }
+
+    size_t batch_errors = 0;
+    for (size_t i = 0; i < batch_results.size(); ++i) {
+      if (batch_results[i]) {
+        continue;
+      }
+
+      fmt::print(
+          stderr,
+          "ERROR: {}: {}\n",
+          batch_config.jobs[i].input_path,
+          batch_results[i].message);
+
+      ++batch_errors;
+    }
+
+    if (batch_errors > 0) {
+      fmt::print(
+          stderr,
+          "{} of {} jobs failed\n",
+          batch_errors,
+          batch_results.size());
+
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  /* run the render server */
+  if (!flag_serve.empty()) {
+    ServerConfig server_config;
+    server_config.socket_path = flag_serve;
+    server_config.font_defaults = flag_font_defaults;
+    server_config.font_load = flag_font_load;
+
+    if (flag_workers > 0) {
+      server_config.worker_count = flag_workers;
+    }
+
+    auto rc = server_run(server_config);
+    error_print(rc, std::cerr);
+    return EXIT_FAILURE;
+  }
+
   /* check if the input flags are valid */
+  bool templated = !flag_template.empty();
+  if (templated) {
+    if (!flag_in.empty()) {
+      std::cerr
+          << "Can't read from an input file (--in) and a template (--template) "
+          << "at the same time\n";
+
+      return 1;
+    }
+
+    flag_in = flag_template;
+  }
+
+  if (!templated && !flag_params.empty()) {
+    std::cerr << "Parameters (--param) can only be bound to a template (--template)\n";
+    return 1;
+  }
+
   if (flag_in.empty() && !flag_stdin) {
     std::cerr << "Need an input file (--in)\n";
     return 1;
@@ -154,6 +268,38 @@ int main(int argc, const char** argv) {
     return EXIT_FAILURE;
   }
 
+  /* read the template parameters */
+  ProgramParams program_params;
+  for (const auto& param : flag_params) {
+    if (auto rc = program_bind_param(param, &program_params); !rc) {
+      error_print(rc, std::cerr);
+      return EXIT_FAILURE;
+    }
+  }
+
+  /* watch the input files */
+  if (flag_watch) {
+    if (flag_stdin || flag_stdout) {
+      std::cerr
+          << "Can't watch stdin (--stdin) or write to stdout (--stdout)\n";
+
+      return 1;
+    }
+
+    WatchConfig watch_config;
+    watch_config.input_path = flag_in;
+    watch_config.output_path = flag_out;
+    watch_config.output_format = output_format;
+    watch_config.templated = templated;
+    watch_config.params = program_params;
+    watch_config.font_defaults = flag_font_defaults;
+    watch_config.font_load = flag_font_load;
+
+    auto rc = watch_run(watch_config);
+    error_print(rc, std::cerr);
+    return EXIT_FAILURE;
+  }
+
   /* set up the context */
   Context ctx;
   ctx.font_defaults = flag_font_defaults;
@@ -182,24 +328,28 @@ int main(int argc, const char** argv) {
   }
 
   /* evaluate the input commands */
-  if (auto rc = clip::eval(&ctx, input); !rc) {
-    error_print(rc, std::cerr);
-    return EXIT_FAILURE;
+  if (templated) {
+    Program program;
+    if (auto rc = program_compile_template(input, &program); !rc) {
+      error_print(rc, std::cerr);
+      return EXIT_FAILURE;
+    }
+
+    if (auto rc = clip::eval(&ctx, program, program_params); !rc) {
+      error_print(rc, std::cerr);
+      return EXIT_FAILURE;
+    }
+  } else {
+    if (auto rc = clip::eval(&ctx, input); !rc) {
+      error_print(rc, std::cerr);
+      return EXIT_FAILURE;
+    }
   }
 
   /* write the output file */
   std::string output_buffer;
-  ReturnCode export_rc;
-  switch (output_format) {
-    case OutputFormat::SVG:
-      export_rc = export_svg(&ctx, &output_buffer);
-      break;
-    //case OutputFormat::PNG:
-    //  export_rc = page_export_png(page, drawlist, output_buffer);
-    //  break;
-  }
-
-  if (!export_rc) {
+  if (auto export_rc = eval_export(&ctx, output_format, &output_buffer);
+      !export_rc) {
     error_print(export_rc, std::cerr);
     return EXIT_FAILURE;
   }
@@ -13,6 +13,7 @@
  */
 #pragma once
 #include "command.h"
+#include "data.h"
 #include "plot/areas.h"
 #include "plot/axis.h"
 #include "plot/bars.h"
@@ -32,6 +33,9 @@ const CommandMap COMMANDS = {
   {"set-width", CommandFn(&context_configure)},
   {"set-height", CommandFn(&context_configure)},
   {"set-dpi", CommandFn(&context_configure)},
+  {"set-glyph-reuse", CommandFn(&context_configure)},
+  {"set-font-embed", CommandFn(&context_configure)},
+  {"data/load", CommandFn(&dataset_load)},
   {"layout/add-margins", CommandFn(&layout_add_margins)},
   {"plot/add-axes", CommandFn(&elements::plot::axis::axis_add_all)},
   {"plot/draw-areas", CommandFn(&elements::plot::areas::areas_draw)},
@@ -22,6 +22,8 @@ Context::Context() :
     width(from_px(1024)),
     height(from_px(512)),
     dpi(96),
+    svg_glyph_reuse(false),
+    svg_font_embed(false),
     font_defaults(true),
     background_color(Color::fromRGB(1, 1, 1)),
     foreground_color(Color::fromRGB(0, 0, 0)),
@@ -45,6 +47,15 @@ ReturnCode context_setup_defaults(Context* ctx) {
   return OK;
 }
 
+void context_reset(Context* ctx) {
+  Context fresh;
+  fresh.font_defaults = ctx->font_defaults;
+  fresh.font_load = std::move(ctx->font_load);
+  fresh.font = std::move(ctx->font);
+  fresh.data_cache = std::move(ctx->data_cache);
+  *ctx = std::move(fresh);
+}
+
 ReturnCode context_configure(Context* ctx, const Expr* expr) {
   auto args = expr_collect(expr);
   if (args.size() < 2) {
@@ -63,6 +74,14 @@ ReturnCode context_configure(Context* ctx, const Expr* expr) {
     return expr_to_float64(args[1], &ctx->dpi);
   }
 
+  if (expr_is_value(args[0], "set-glyph-reuse")) {
+    return expr_to_switch(args[1], &ctx->svg_glyph_reuse);
+  }
+
+  if (expr_is_value(args[0], "set-font-embed")) {
+    return expr_to_switch(args[1], &ctx->svg_font_embed);
+  }
+
   return errorf(ERROR, "Unknown command: {}", expr_get_value(args[0]));
 }
 
@@ -18,6 +18,9 @@
 #include "color_palette.h"
 
 namespace clip {
+struct Dataset;
+struct DataCache;
+struct Column;
 
 struct Context {
   Context();
@@ -25,6 +28,8 @@ struct Context {
   Measure width;
   Measure height;
   double dpi;
+  bool svg_glyph_reuse;
+  bool svg_font_embed;
 
   bool font_defaults;
   std::vector<std::string> font_load;
@@ -43,10 +48,19 @@ struct Context {
   std::vector<Rectangle> layout_stack;
 
   std::unordered_map<std::string, ExprStorage> defaults;
+  std::unordered_map<std::string, std::shared_ptr<const Dataset>> datasets;
+  std::unordered_map<std::string, std::shared_ptr<const Column>> columns;
+  std::shared_ptr<DataCache> data_cache;
 };
 
 ReturnCode context_setup_defaults(Context* ctx);
 
+/**
+ * Reset the context to the state of a new context but keep the loaded fonts
+ * and the data cache
+ */
+void context_reset(Context* ctx);
+
 ReturnCode context_configure(Context* ctx, const Expr* expr);
 
 ReturnCode context_set_default(Context* ctx, const Expr* expr);
@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #include "data.h"
+#include "context.h"
 #include "utils/fileutil.h"
 #include "utils/csv.h"
 #include "sexpr_conv.h"
@@ -66,6 +67,26 @@ Value value_from_float(double v) {
   return std::to_string(v);
 }
 
+/**
+ * Parse a value that consists only of a number, i.e. a value that
+ * parse_measure reads as a user unit
+ */
+bool value_parse_number(const Value& v, double* number) {
+  size_t number_len;
+  try {
+    *number = std::stod(v, &number_len);
+  } catch (...) {
+    return false;
+  }
+
+  return number_len == v.size();
+}
+
+DataValues::DataValues() :
+    size(0),
+    numbers(nullptr),
+    strings(nullptr) {}
+
 std::vector<DataGroup> series_group(const Series& data) {
   std::vector<DataGroup> groups;
   std::unordered_map<Value, size_t> group_map;
@@ -87,7 +108,74 @@ std::vector<DataGroup> series_group(const Series& data) {
   return groups;
 }
 
+ReturnCode data_read_csv_file(
+    const std::string& path,
+    std::shared_ptr<const CSVData>* data) {
+  std::string data_str;
+  if (auto rc = read_file(path, &data_str); !rc) {
+    return rc;
+  }
+
+  auto data_csv = std::make_shared<CSVData>();
+  if (auto rc = csv_parse(data_str, data_csv.get()); !rc) {
+    return rc;
+  }
+
+  *data = std::move(data_csv);
+  return OK;
+}
+
+ReturnCode data_read_csv(
+    const Context* ctx,
+    const std::string& path,
+    std::shared_ptr<const CSVData>* data) {
+  auto cache = ctx->data_cache.get();
+  if (!cache) {
+    return data_read_csv_file(path, data);
+  }
+
+  std::shared_ptr<DataCacheEntry> entry;
+  {
+    std::lock_guard<std::mutex> lk(cache->lock);
+    auto& entry_slot = cache->entries[path];
+    if (!entry_slot) {
+      entry_slot = std::make_shared<DataCacheEntry>();
+      entry_slot->loaded = false;
+    }
+
+    entry = entry_slot;
+  }
+
+  // the entry is locked while the file is parsed so that concurrent readers
+  // of the same file wait for the first one instead of parsing it again
+  std::lock_guard<std::mutex> lk(entry->lock);
+  if (!entry->loaded) {
+    entry->result = data_read_csv_file(path, &entry->csv);
+    entry->loaded = true;
+  }
+
+  *data = entry->csv;
+  return entry->result;
+}
+
+std::vector<std::string> data_cache_list(DataCache* cache) {
+  std::lock_guard<std::mutex> lk(cache->lock);
+
+  std::vector<std::string> paths;
+  for (const auto& entry : cache->entries) {
+    paths.emplace_back(entry.first);
+  }
+
+  return paths;
+}
+
+void data_cache_invalidate(DataCache* cache, const std::string& path) {
+  std::lock_guard<std::mutex> lk(cache->lock);
+  cache->entries.erase(path);
+}
+
 ReturnCode data_load_strings_csv(
+    const Context* ctx,
     const Expr* expr,
     std::vector<std::string>* values) {
   auto args = expr_collect(expr);
@@ -104,16 +192,12 @@ ReturnCode data_load_strings_csv(
   const auto& path = expr_get_value(args[0]);
   const auto& column_name = expr_get_value(args[1]);
 
-  std::string data_str;
-  if (auto rc = read_file(path, &data_str); !rc) {
-    return rc;
-  }
-
-  auto data_csv = CSVData{};
-  if (auto rc = csv_parse(data_str, &data_csv); !rc) {
+  std::shared_ptr<const CSVData> data_csv_ref;
+  if (auto rc = data_read_csv(ctx, path, &data_csv_ref); !rc) {
     return rc;
   }
 
+  const auto& data_csv = *data_csv_ref;
   if (data_csv.empty()) {
     return OK;
   }
@@ -142,14 +226,113 @@ ReturnCode data_load_strings_csv(
   return OK;
 }
 
-ReturnCode data_load_csv(
+ReturnCode data_get_dataset_column(
+    const Context* ctx,
     const Expr* expr,
-    std::vector<Measure>* values) {
-  std::vector<std::string> values_str;
-  if (auto rc = data_load_strings_csv(expr, &values_str); !rc) {
+    DatasetColumnRef* column) {
+  auto args = expr_collect(expr);
+  if (args.size() != 2 ||
+      !expr_is_value(args[0]) ||
+      !expr_is_value(args[1])) {
+    return errorf(
+        ERROR,
+        "invalid number of arguments to 'data'; expected: 2, got: {}",
+        args.size());
+  }
+
+  return dataset_get_column(
+      ctx,
+      expr_get_value(args[0]),
+      expr_get_value(args[1]),
+      column);
+}
+
+ReturnCode data_load_strings_dataset(
+    const Context* ctx,
+    const Expr* expr,
+    std::vector<std::string>* values) {
+  DatasetColumnRef column;
+  if (auto rc = data_get_dataset_column(ctx, expr, &column); !rc) {
     return rc;
   }
 
+  values->insert(values->end(), column->values.begin(), column->values.end());
+  return OK;
+}
+
+ReturnCode data_get_column(
+    const Context* ctx,
+    const Expr* expr,
+    const Column** column) {
+  auto args = expr_collect(expr);
+  if (args.size() != 1 || !expr_is_value(args[0])) {
+    return errorf(
+        ERROR,
+        "invalid number of arguments to 'column'; expected: 1, got: {}",
+        args.size());
+  }
+
+  const auto& column_name = expr_get_value(args[0]);
+  const auto& column_iter = ctx->columns.find(column_name);
+  if (column_iter == ctx->columns.end()) {
+    return errorf(
+        ERROR,
+        "column not found: '{}'; columns must be bound with clip_bind_column",
+        column_name);
+  }
+
+  *column = column_iter->second.get();
+  return OK;
+}
+
+ReturnCode data_load_strings_column(
+    const Context* ctx,
+    const Expr* expr,
+    std::vector<std::string>* values) {
+  const Column* column;
+  if (auto rc = data_get_column(ctx, expr, &column); !rc) {
+    return rc;
+  }
+
+  values->reserve(values->size() + column->size);
+
+  switch (column->type) {
+    case ColumnType::FLOAT64: {
+      auto data = static_cast<const double*>(column->data);
+      for (size_t i = 0; i < column->size; ++i) {
+        values->emplace_back(fmt::format("{}", data[i]));
+      }
+      break;
+    }
+    case ColumnType::INT64: {
+      auto data = static_cast<const int64_t*>(column->data);
+      for (size_t i = 0; i < column->size; ++i) {
+        values->emplace_back(std::to_string(data[i]));
+      }
+      break;
+    }
+    case ColumnType::TIMESTAMP: {
+      auto data = static_cast<const int64_t*>(column->data);
+      for (size_t i = 0; i < column->size; ++i) {
+        values->emplace_back(fmt::format("{}", data[i] / 1000000.0));
+      }
+      break;
+    }
+    case ColumnType::STRING: {
+      auto data = static_cast<const char* const*>(column->data);
+      for (size_t i = 0; i < column->size; ++i) {
+        values->emplace_back(data[i]);
+      }
+      break;
+    }
+  }
+
+  return OK;
+}
+
+ReturnCode data_parse_numbers(
+    const std::vector<std::string>& values_str,
+    std::vector<Measure>* values) {
   for (auto v = values_str.begin(); v != values_str.end(); ++v) {
     try {
       values->push_back(from_user(std::stod(*v)));
@@ -165,7 +348,89 @@ ReturnCode data_load_csv(
   return OK;
 }
 
+ReturnCode data_load_csv(
+    const Context* ctx,
+    const Expr* expr,
+    std::vector<Measure>* values) {
+  std::vector<std::string> values_str;
+  if (auto rc = data_load_strings_csv(ctx, expr, &values_str); !rc) {
+    return rc;
+  }
+
+  return data_parse_numbers(values_str, values);
+}
+
+ReturnCode data_load_dataset(
+    const Context* ctx,
+    const Expr* expr,
+    std::vector<Measure>* values) {
+  DatasetColumnRef column;
+  if (auto rc = data_get_dataset_column(ctx, expr, &column); !rc) {
+    return rc;
+  }
+
+  // numeric columns were parsed when the dataset was loaded
+  if (!column->numeric) {
+    return data_parse_numbers(column->values, values);
+  }
+
+  values->reserve(values->size() + column->numbers.size());
+  for (auto v : column->numbers) {
+    values->push_back(from_user(v));
+  }
+
+  return OK;
+}
+
+ReturnCode data_load_column(
+    const Context* ctx,
+    const Expr* expr,
+    std::vector<Measure>* values) {
+  const Column* column;
+  if (auto rc = data_get_column(ctx, expr, &column); !rc) {
+    return rc;
+  }
+
+  values->reserve(values->size() + column->size);
+
+  // numeric columns are converted directly without going through strings
+  switch (column->type) {
+    case ColumnType::FLOAT64: {
+      auto data = static_cast<const double*>(column->data);
+      for (size_t i = 0; i < column->size; ++i) {
+        values->push_back(from_user(data[i]));
+      }
+      return OK;
+    }
+    case ColumnType::INT64: {
+      auto data = static_cast<const int64_t*>(column->data);
+      for (size_t i = 0; i < column->size; ++i) {
+        values->push_back(from_user(data[i]));
+      }
+      return OK;
+    }
+    case ColumnType::TIMESTAMP: {
+      auto data = static_cast<const int64_t*>(column->data);
+      for (size_t i = 0; i < column->size; ++i) {
+        values->push_back(from_user(data[i] / 1000000.0));
+      }
+      return OK;
+    }
+    case ColumnType::STRING: {
+      std::vector<std::string> values_str;
+      if (auto rc = data_load_strings_column(ctx, expr, &values_str); !rc) {
+        return rc;
+      }
+
+      return data_parse_numbers(values_str, values);
+    }
+  }
+
+  return OK;
+}
+
 ReturnCode data_load_strings(
+    const Context* ctx,
     const Expr* expr,
     std::vector<std::string>* values) {
   if (!expr || !expr_is_list(expr)) {
@@ -178,13 +443,22 @@ ReturnCode data_load_strings(
   auto args = expr_get_list(expr);
 
   if (args && expr_is_value_literal(args, "csv")) {
-    return data_load_strings_csv(expr_next(args), values);
+    return data_load_strings_csv(ctx, expr_next(args), values);
+  }
+
+  if (args && expr_is_value_literal(args, "data")) {
+    return data_load_strings_dataset(ctx, expr_next(args), values);
+  }
+
+  if (args && expr_is_value_literal(args, "column")) {
+    return data_load_strings_column(ctx, expr_next(args), values);
   }
 
   return expr_to_strings(expr, values);
 }
 
 ReturnCode data_load(
+    const Context* ctx,
     const Expr* expr,
     std::vector<Measure>* values) {
   if (!expr || !expr_is_list(expr)) {
@@ -197,38 +471,184 @@ ReturnCode data_load(
   auto args = expr_get_list(expr);
 
   if (args && expr_is_value_literal(args, "csv")) {
-    return data_load_csv(expr_next(args), values);
+    return data_load_csv(ctx, expr_next(args), values);
+  }
+
+  if (args && expr_is_value_literal(args, "data")) {
+    return data_load_dataset(ctx, expr_next(args), values);
+  }
+
+  if (args && expr_is_value_literal(args, "column")) {
+    return data_load_column(ctx, expr_next(args), values);
   }
 
   return measure_read_list(expr, values);
 }
 
+void data_values_from_strings(
+    std::vector<std::string>&& strings,
+    DataValues* values) {
+  auto storage = std::make_shared<std::vector<std::string>>(std::move(strings));
+  values->size = storage->size();
+  values->numbers = nullptr;
+  values->strings = storage->data();
+  values->storage = std::move(storage);
+}
+
+void data_values_from_numbers(
+    std::vector<double>&& numbers,
+    DataValues* values) {
+  auto storage = std::make_shared<std::vector<double>>(std::move(numbers));
+  values->size = storage->size();
+  values->numbers = storage->data();
+  values->strings = nullptr;
+  values->storage = std::move(storage);
+}
+
+ReturnCode data_load_values_dataset(
+    const Context* ctx,
+    const Expr* expr,
+    DataValues* values) {
+  DatasetColumnRef column;
+  if (auto rc = data_get_dataset_column(ctx, expr, &column); !rc) {
+    return rc;
+  }
+
+  values->size = column->values.size();
+  values->numbers = column->numeric ? column->numbers.data() : nullptr;
+  values->strings = column->values.data();
+  values->storage = std::move(column);
+  return OK;
+}
+
+ReturnCode data_load_values_column(
+    const Context* ctx,
+    const Expr* expr,
+    DataValues* values) {
+  const Column* column;
+  if (auto rc = data_get_column(ctx, expr, &column); !rc) {
+    return rc;
+  }
+
+  switch (column->type) {
+    case ColumnType::FLOAT64: {
+      // the column is read in place; it remains valid until the context is
+      // reset
+      values->size = column->size;
+      values->numbers = static_cast<const double*>(column->data);
+      values->strings = nullptr;
+      values->storage.reset();
+      return OK;
+    }
+    case ColumnType::INT64: {
+      auto data = static_cast<const int64_t*>(column->data);
+      std::vector<double> numbers(data, data + column->size);
+      data_values_from_numbers(std::move(numbers), values);
+      return OK;
+    }
+    case ColumnType::TIMESTAMP: {
+      auto data = static_cast<const int64_t*>(column->data);
+      std::vector<double> numbers(column->size);
+      for (size_t i = 0; i < column->size; ++i) {
+        numbers[i] = data[i] / 1000000.0;
+      }
+
+      data_values_from_numbers(std::move(numbers), values);
+      return OK;
+    }
+    case ColumnType::STRING: {
+      std::vector<std::string> strings;
+      if (auto rc = data_load_strings_column(ctx, expr, &strings); !rc) {
+        return rc;
+      }
+
+      data_values_from_strings(std::move(strings), values);
+      return OK;
+    }
+  }
+
+  return OK;
+}
+
+ReturnCode data_load_values(
+    const Context* ctx,
+    const Expr* expr,
+    DataValues* values) {
+  if (!expr) {
+    return error(ERROR, "argument error; expected a list of values");
+  }
+
+  if (!expr_is_list(expr)) {
+    return errorf(
+        ERROR,
+        "argument error; expected a list of values, got: {}",
+        expr_inspect(expr));
+  }
+
+  auto args = expr_get_list(expr);
+
+  if (args && expr_is_value_literal(args, "data")) {
+    return data_load_values_dataset(ctx, expr_next(args), values);
+  }
+
+  if (args && expr_is_value_literal(args, "column")) {
+    return data_load_values_column(ctx, expr_next(args), values);
+  }
+
+  std::vector<std::string> strings;
+  if (args && expr_is_value_literal(args, "csv")) {
+    if (auto rc = data_load_strings_csv(ctx, expr_next(args), &strings); !rc) {
+      return rc;
+    }
+  } else {
+    if (auto rc = expr_to_strings(expr, &strings); !rc) {
+      return rc;
+    }
+  }
+
+  data_values_from_strings(std::move(strings), values);
+  return OK;
+}
+
 ReturnCode data_to_measures(
-    std::vector<std::string>& src,
+    const DataValues& src,
     const ScaleConfig& scale,
     std::vector<Measure>* dst) {
-  for (auto v = src.begin(); v != src.end(); ++v) {
+  dst->reserve(dst->size() + src.size);
+
+  // numbers are converted directly unless they are looked up as categories
+  if (src.numbers && scale.kind != ScaleKind::CATEGORICAL) {
+    for (size_t i = 0; i < src.size; ++i) {
+      dst->push_back(from_user(src.numbers[i]));
+    }
+
+    return OK;
+  }
+
+  for (size_t i = 0; i < src.size; ++i) {
+    auto v = src.strings ? src.strings[i] : fmt::format("{}", src.numbers[i]);
+
     Measure m;
     switch (scale.kind) {
       case ScaleKind::CATEGORICAL: {
-        auto v_iter = scale.categories_map.find(*v);
+        auto v_iter = scale.categories_map.find(v);
         if (v_iter == scale.categories_map.end()) {
           return errorf(
               ERROR,
               "error while parsing data: value '{}' is not part of the categories list",
-              *v);
+              v);
         }
 
         m = from_rel(scale_translate_categorical(scale, v_iter->second));
         break;
       }
       default:
-        if (auto rc = parse_measure(*v, &m); !rc) {
+        if (auto rc = parse_measure(v, &m); !rc) {
           return errorf(
               ERROR,
               "error while parsing data: '{}': {} -- "
               "if this is intentional, set 'scale-[x,y] to (categorical ...)'",
-              *v,
+              v,
               rc.message);
         }
         break;
@@ -240,6 +660,155 @@ ReturnCode data_to_measures(
   return OK;
 }
 
+/**
+ * Parse the values of a dataset column. The numbers are only kept if every
+ * value in the column is a number.
+ */
+void dataset_column_parse(DatasetColumn* column) {
+  column->numeric = true;
+  column->numbers.reserve(column->values.size());
+
+  for (const auto& v : column->values) {
+    double number;
+    if (!value_parse_number(v, &number)) {
+      column->numeric = false;
+      column->numbers = std::vector<double>();
+      return;
+    }
+
+    column->numbers.push_back(number);
+  }
+}
+
+ReturnCode dataset_load_csv(
+    const Context* ctx,
+    const Expr* expr,
+    Dataset* dataset) {
+  auto args = expr_collect(expr);
+  if (args.size() != 1 || !expr_is_value(args[0])) {
+    return errorf(
+        ERROR,
+        "invalid number of arguments to 'csv'; expected: 1, got: {}",
+        args.size());
+  }
+
+  const auto& path = expr_get_value(args[0]);
+
+  std::shared_ptr<const CSVData> data_csv_ref;
+  if (auto rc = data_read_csv(ctx, path, &data_csv_ref); !rc) {
+    return rc;
+  }
+
+  const auto& data_csv = *data_csv_ref;
+  if (data_csv.empty()) {
+    return OK;
+  }
+
+  const auto& headers = data_csv.front();
+  std::vector<Series> columns(headers.size());
+  for (auto row = ++data_csv.begin(); row != data_csv.end(); ++row) {
+    if (row->size() < headers.size()) {
+      return errorf(
+          ERROR,
+          "CSV invalid number of columns for row #{}",
+          std::distance(data_csv.begin(), row));
+    }
+
+    for (size_t i = 0; i < headers.size(); ++i) {
+      columns[i].emplace_back(row->at(i));
+    }
+  }
+
+  for (size_t i = 0; i < headers.size(); ++i) {
+    if (dataset->columns.count(headers[i])) {
+      continue;
+    }
+
+    auto column = std::make_shared<DatasetColumn>();
+    column->values = std::move(columns[i]);
+    dataset_column_parse(column.get());
+
+    dataset->column_names.emplace_back(headers[i]);
+    dataset->columns[headers[i]] = std::move(column);
+  }
+
+  return OK;
+}
+
+ReturnCode dataset_load(
+    Context* ctx,
+    const Expr* expr) {
+  auto args = expr_collect(expr);
+  if (args.size() != 3) {
+    return error(
+        ERROR,
+        "invalid number of arguments to 'data/load'; "
+        "expected: (data/load <name> <source>)");
+  }
+
+  if (!expr_is_value(args[1])) {
+    return errorf(
+        ERROR,
+        "the first argument to 'data/load' must be the dataset name, got: {}",
+        expr_inspect(args[1]));
+  }
+
+  auto dataset = std::make_shared<Dataset>();
+  if (expr_is_list(args[2], "csv")) {
+    auto source_args = expr_next(expr_get_list(args[2]));
+    if (auto rc = dataset_load_csv(ctx, source_args, dataset.get()); !rc) {
+      return rc;
+    }
+  } else {
+    return errorf(
+        ERROR,
+        "invalid data source: {}; expected: (csv <file>)",
+        expr_inspect(args[2]));
+  }
+
+  ctx->datasets[expr_get_value(args[1])] = std::move(dataset);
+  return OK;
+}
+
+void data_bind_column(
+    Context* ctx,
+    const std::string& name,
+    ColumnType type,
+    const void* data,
+    size_t size) {
+  auto column = std::make_shared<Column>();
+  column->type = type;
+  column->data = data;
+  column->size = size;
+  ctx->columns[name] = std::move(column);
+}
+
+ReturnCode dataset_get_column(
+    const Context* ctx,
+    const std::string& dataset_name,
+    const std::string& column_name,
+    DatasetColumnRef* column) {
+  const auto& dataset = ctx->datasets.find(dataset_name);
+  if (dataset == ctx->datasets.end()) {
+    return errorf(
+        ERROR,
+        "dataset not found: '{}'; datasets must be loaded with 'data/load' "
+        "before they can be referenced",
+        dataset_name);
+  }
+
+  const auto& dataset_column = dataset->second->columns.find(column_name);
+  if (dataset_column == dataset->second->columns.end()) {
+    return errorf(
+        ERROR,
+        "column not found in dataset '{}': {}",
+        dataset_name,
+        column_name);
+  }
+
+  *column = dataset_column->second;
+  return OK;
+}
 
 } // namespace clip
 
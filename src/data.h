@@ -12,19 +12,109 @@
  * limitations under the License.
  */
 #pragma once
+#include <mutex>
 #include <string>
 #include <vector>
 #include "return_code.h"
+#include "utils/csv.h"
 #include "graphics/measure.h"
 #include "scale.h"
 #include "sexpr_conv.h"
 
 namespace clip {
+struct Context;
 
 using Value = std::string;
 using Series = std::vector<Value>;
 using SeriesRef = std::shared_ptr<const Series>;
-using SeriesMap = std::unordered_map<std::string, SeriesRef>;
+
+/**
+ * The values of a dataset column are parsed once when the dataset is loaded.
+ * If every value in the column is a number, the parsed numbers are stored
+ * alongside the values so that numeric references to the column do not need
+ * to parse it again.
+ */
+struct DatasetColumn {
+  Series values;
+  std::vector<double> numbers;
+  bool numeric;
+};
+
+using DatasetColumnRef = std::shared_ptr<const DatasetColumn>;
+
+/**
+ * A dataset is a named table of immutable columns. Datasets are loaded once
+ * using the `data/load` command and are stored in the context so that any
+ * number of commands can reference the same columns using `(data <name> <col>)`
+ */
+struct Dataset {
+  std::vector<std::string> column_names;
+  std::unordered_map<std::string, DatasetColumnRef> columns;
+};
+
+using DatasetRef = std::shared_ptr<const Dataset>;
+
+/**
+ * A column is an array of values that is owned by the host application and
+ * bound to the context using the C API. Columns are referenced using
+ * `(column <name>)` and are read in place; the array must remain valid until
+ * the context is reset. Timestamps are given in microseconds since the unix
+ * epoch.
+ */
+enum class ColumnType {
+  FLOAT64,
+  INT64,
+  STRING,
+  TIMESTAMP
+};
+
+struct Column {
+  ColumnType type;
+  const void* data;
+  size_t size;
+};
+
+/**
+ * The values of a data property, e.g. `data-x`, as they were loaded and before
+ * they are converted to measures using the scale of the property. Numeric
+ * dataset columns and numeric bound columns are referenced as numbers without
+ * copying or formatting them; all other values are stored as strings. Numeric
+ * dataset columns provide both their numbers and their original values.
+ */
+struct DataValues {
+  DataValues();
+
+  size_t size;
+  const double* numbers;
+  const std::string* strings;
+  std::shared_ptr<const void> storage;
+};
+
+/**
+ * The data cache keeps parsed data files in memory so that a file that is
+ * referenced by more than one command or chart is only read and parsed once.
+ * A data cache may be shared between any number of contexts and threads.
+ */
+struct DataCacheEntry {
+  std::mutex lock;
+  bool loaded;
+  ReturnCode result;
+  std::shared_ptr<const CSVData> csv;
+};
+
+struct DataCache {
+  std::mutex lock;
+  std::unordered_map<std::string, std::shared_ptr<DataCacheEntry>> entries;
+};
+
+ReturnCode data_read_csv(
+    const Context* ctx,
+    const std::string& path,
+    std::shared_ptr<const CSVData>* data);
+
+std::vector<std::string> data_cache_list(DataCache* cache);
+
+void data_cache_invalidate(DataCache* cache, const std::string& path);
 
 struct DataGroup {
   Value key;
@@ -49,24 +139,49 @@ std::vector<Measure> series_to_sizes(
     const Measure& high);
 
 ReturnCode data_load_strings(
+    const Context* ctx,
     const Expr* expr,
     std::vector<std::string>* values);
 
 ReturnCode data_load(
+    const Context* ctx,
     const Expr* expr,
     std::vector<Measure>* values);
 
 template <typename T>
 ReturnCode data_load_as(
+    const Context* ctx,
     const Expr* expr,
     std::function<ReturnCode (const std::string&, T*)> conv,
     std::vector<T>* dst);
 
+ReturnCode data_load_values(
+    const Context* ctx,
+    const Expr* expr,
+    DataValues* values);
+
 ReturnCode data_to_measures(
-    std::vector<std::string>& src,
+    const DataValues& src,
     const ScaleConfig& scale,
     std::vector<Measure>* dst);
 
+ReturnCode dataset_load(
+    Context* ctx,
+    const Expr* expr);
+
+void data_bind_column(
+    Context* ctx,
+    const std::string& name,
+    ColumnType type,
+    const void* data,
+    size_t size);
+
+ReturnCode dataset_get_column(
+    const Context* ctx,
+    const std::string& dataset_name,
+    const std::string& column_name,
+    DatasetColumnRef* column);
+
 } // namespace clip
 
 #include "data_impl.h"
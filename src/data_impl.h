@@ -17,11 +17,12 @@ namespace clip {
 
 template <typename T>
 ReturnCode data_load_as(
+    const Context* ctx,
     const Expr* expr,
     std::function<ReturnCode (const std::string&, T*)> conv,
     std::vector<T>* dst) {
   std::vector<std::string> data;
-  if (auto rc = data_load_strings(expr, &data); !rc) {
+  if (auto rc = data_load_strings(ctx, expr, &data); !rc) {
     return rc;
   }
 
@@ -20,30 +20,39 @@
 
 namespace clip {
 
+ReturnCode eval_lookup_command(
+    const Expr* expr,
+    const Command** cmd) {
+  if (!expr || !expr_is_list(expr)) {
+    return error(ERROR, "expected a command list");
+  }
+
+  auto args = expr_get_list(expr);
+  if (!args || !expr_is_value(args)) {
+    return error(ERROR, "expected a command name");
+  }
+
+  auto arg0 = expr_get_value(args);
+  if (auto cmd_iter = COMMANDS.find(arg0); cmd_iter != COMMANDS.end()) {
+    *cmd = &cmd_iter->second;
+  } else {
+    return {ERROR, fmt::format("Invalid command '{}'", arg0)};
+  }
+
+  return OK;
+}
+
 ReturnCode eval(
     Context* ctx,
     const Expr* expr) {
   // execute commands
   for (; expr; expr = expr_next(expr)) {
-    if (!expr || !expr_is_list(expr)) {
-      return error(ERROR, "expected a command list");
-    }
-
-    auto args = expr_get_list(expr);
-    if (!args || !expr_is_value(args)) {
-      return error(ERROR, "expected a command name");
-    }
-
-    auto arg0 = expr_get_value(args);
-
     const Command* cmd;
-    if (auto cmd_iter = COMMANDS.find(arg0); cmd_iter != COMMANDS.end()) {
-      cmd = &cmd_iter->second;
-    } else {
-      return {ERROR, fmt::format("Invalid command '{}'", arg0)};
+    if (auto rc = eval_lookup_command(expr, &cmd); !rc) {
+      return rc;
     }
 
-    if (auto rc = cmd->fn(ctx, args); !rc) {
+    if (auto rc = cmd->fn(ctx, expr_get_list(expr)); !rc) {
       return rc;
     }
   }
@@ -62,5 +71,172 @@ ReturnCode eval(
   return eval(ctx, expr.get());
 }
 
+bool program_is_param(const Expr* expr) {
+  return
+      expr_is_value_literal(expr) &&
+      expr_get_value(expr).size() > 1 &&
+      expr_get_value(expr)[0] == '$';
+}
+
+void program_collect_params(
+    const Expr* expr,
+    std::set<std::string>* params) {
+  for (; expr; expr = expr_next(expr)) {
+    if (expr_is_list(expr)) {
+      program_collect_params(expr_get_list(expr), params);
+      continue;
+    }
+
+    if (program_is_param(expr)) {
+      params->insert(expr_get_value(expr).substr(1));
+    }
+  }
+}
+
+ReturnCode program_compile(
+    const std::string& input,
+    bool templated,
+    Program* program) {
+  if (auto rc = expr_parse(input.data(), input.length(), &program->expr); !rc) {
+    return rc;
+  }
+
+  for (auto expr = program->expr.get(); expr; expr = expr_next(expr)) {
+    ProgramCommand cmd;
+    if (auto rc = eval_lookup_command(expr, &cmd.command); !rc) {
+      return rc;
+    }
+
+    // parameter slots are only recognized in templates; in all other
+    // programs `$name` is an ordinary value
+    std::set<std::string> cmd_params;
+    if (templated) {
+      program_collect_params(expr_get_list(expr), &cmd_params);
+    }
+
+    cmd.expr = expr;
+    cmd.has_params = !cmd_params.empty();
+    program->commands.emplace_back(cmd);
+    program->params.insert(cmd_params.begin(), cmd_params.end());
+  }
+
+  return OK;
+}
+
+ReturnCode program_compile(
+    const std::string& input,
+    Program* program) {
+  return program_compile(input, false, program);
+}
+
+ReturnCode program_compile_template(
+    const std::string& input,
+    Program* program) {
+  return program_compile(input, true, program);
+}
+
+ReturnCode program_bind_param(
+    const std::string& param,
+    ProgramParams* params) {
+  auto sep = param.find('=');
+  if (sep == std::string::npos || sep == 0) {
+    return errorf(
+        ERROR,
+        "invalid parameter '{}'; expected: <name>=<value>",
+        param);
+  }
+
+  (*params)[param.substr(0, sep)] = param.substr(sep + 1);
+  return OK;
+}
+
+ReturnCode program_substitute_params(
+    Expr* expr,
+    const ProgramParams& params) {
+  for (; expr; expr = expr_next(expr)) {
+    if (expr_is_list(expr)) {
+      auto list = expr_get_list_storage(expr)->get();
+      if (auto rc = program_substitute_params(list, params); !rc) {
+        return rc;
+      }
+
+      continue;
+    }
+
+    if (!program_is_param(expr)) {
+      continue;
+    }
+
+    auto param_name = expr_get_value(expr).substr(1);
+    auto param = params.find(param_name);
+    if (param == params.end()) {
+      return errorf(ERROR, "missing value for parameter '{}'", param_name);
+    }
+
+    expr_set_value(expr, param->second);
+  }
+
+  return OK;
+}
+
+ReturnCode eval(
+    Context* ctx,
+    const Program& program,
+    const ProgramParams& params) {
+  for (const auto& cmd : program.commands) {
+    auto args = expr_get_list(cmd.expr);
+
+    // commands without parameter slots are evaluated directly from the shared
+    // program; all others are evaluated on a private copy with the parameter
+    // values filled in
+    if (!cmd.has_params) {
+      if (auto rc = cmd.command->fn(ctx, args); !rc) {
+        return rc;
+      }
+
+      continue;
+    }
+
+    auto args_bound = expr_clone(args);
+    if (auto rc = program_substitute_params(args_bound.get(), params); !rc) {
+      return rc;
+    }
+
+    if (auto rc = cmd.command->fn(ctx, args_bound.get()); !rc) {
+      return rc;
+    }
+  }
+
+  return OK;
+}
+
+ReturnCode eval_export(
+    const Context* ctx,
+    OutputFormat format,
+    std::string* buffer) {
+  switch (format) {
+    case OutputFormat::SVG:
+      return export_svg(ctx, buffer);
+    case OutputFormat::PNG:
+      return export_png(ctx, buffer);
+    default:
+      return error(ERROR, "output format not supported");
+  }
+}
+
+ReturnCode eval_export(
+    const Context* ctx,
+    OutputFormat format,
+    const ExportWriteFn& write) {
+  switch (format) {
+    case OutputFormat::SVG:
+      return export_svg(ctx, write);
+    case OutputFormat::PNG:
+      return export_png(ctx, write);
+    default:
+      return error(ERROR, "output format not supported");
+  }
+}
+
 } // namespace clip
 
@@ -12,7 +12,10 @@
  * limitations under the License.
  */
 #pragma once
+#include <set>
+#include "command.h"
 #include "context.h"
+#include "graphics/export_svg.h"
 #include "sexpr.h"
 #include "return_code.h"
 
@@ -20,6 +23,42 @@ namespace clip {
 
 enum class OutputFormat { SVG, PNG };
 
+/**
+ * A program is a pre-parsed list of commands where each command has already
+ * been resolved against the command table. Programs are compiled once and can
+ * then be evaluated any number of times.
+ *
+ * Programs that were compiled as a template may contain parameter slots, i.e.
+ * unquoted values of the form `$name`. The slots are replaced with the bound
+ * parameter values each time the program is evaluated. The program itself is
+ * never modified, so a single program may be shared between many evaluations.
+ */
+struct ProgramCommand {
+  const Command* command;
+  const Expr* expr;
+  bool has_params;
+};
+
+struct Program {
+  ExprStorage expr;
+  std::vector<ProgramCommand> commands;
+  std::set<std::string> params;
+};
+
+using ProgramParams = std::unordered_map<std::string, std::string>;
+
+ReturnCode program_compile(
+    const std::string& input,
+    Program* program);
+
+ReturnCode program_compile_template(
+    const std::string& input,
+    Program* program);
+
+ReturnCode program_bind_param(
+    const std::string& param,
+    ProgramParams* params);
+
 ReturnCode eval(
     Context* ctx,
     const Expr* expr);
@@ -28,5 +67,20 @@ ReturnCode eval(
     Context* ctx,
     const std::string& input);
 
+ReturnCode eval(
+    Context* ctx,
+    const Program& program,
+    const ProgramParams& params);
+
+ReturnCode eval_export(
+    const Context* ctx,
+    OutputFormat format,
+    std::string* buffer);
+
+ReturnCode eval_export(
+    const Context* ctx,
+    OutputFormat format,
+    const ExportWriteFn& write);
+
 } // namespace clip
 
@@ -62,23 +62,25 @@ ReturnCode legend_item_calculate_size(
     double* min_height) {
   legend_item_normalize(ctx, config);
 
-  /* add label extents */
-  TextStyle style;
-  style.font = config->label_font;
-  style.font_size = config->label_font_size;
-
-  Rectangle label_bbox;
-  if (auto rc = text_measure_label(
-        config->label,
-        TextDirection::LTR,
-        config->label_font,
-        config->label_font_size,
-        ctx->dpi,
-        &label_bbox);
-       rc != Status::OK) {
-    return rc;
+  /* add label extents; the legend layout may calculate the size of an item
+     multiple times, but the label is only laid out once */
+  if (!config->label_layout) {
+    TextStyle style;
+    style.font = config->label_font;
+    style.color = config->label_color;
+    style.font_size = config->label_font_size;
+
+    TextLayout label_layout;
+    if (auto rc = text_layout_label(ctx, config->label, style, &label_layout);
+        !rc) {
+      return rc;
+    }
+
+    config->label_layout = std::move(label_layout);
   }
 
+  auto label_bbox = config->label_layout->bbox;
+
   *min_height += label_bbox.h;
   *min_width += label_bbox.w;
 
@@ -116,6 +118,10 @@ ReturnCode draw_label(
       break;
   }
 
+  if (config.label_layout) {
+    return draw_text(ctx, *config.label_layout, p, ax, ay, 0);
+  }
+
   if (auto rc = draw_text(ctx, text, p, ax, ay, style); !rc) {
     return rc;
   }
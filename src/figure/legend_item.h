@@ -29,6 +29,10 @@ struct LegendItem {
   Measure marker_margin;
   Color marker_color;
   Measure marker_size;
+
+  // the label layout is computed when the size of the item is calculated and
+  // reused when the item is drawn
+  std::optional<TextLayout> label_layout;
 };
 
 ReturnCode legend_item_configure(
@@ -264,11 +264,12 @@ Formatter format_custom(const std::vector<std::string>& values) {
 }
 
 ReturnCode format_configure_custom(
+    const Context* ctx,
     const Expr* expr,
     Formatter* formatter) {
   std::vector<std::string> values;
   if (expr && expr_is_list(expr)) {
-    if (auto rc = data_load_strings(expr, &values); !rc) {
+    if (auto rc = data_load_strings(ctx, expr, &values); !rc) {
       return rc;
     }
   } else {
@@ -282,6 +283,7 @@ ReturnCode format_configure_custom(
 }
 
 ReturnCode format_configure(
+    const Context* ctx,
     const Expr* expr,
     Formatter* formatter) {
   if (!expr || !expr_is_list(expr)) {
@@ -314,7 +316,7 @@ ReturnCode format_configure(
   }
 
   if (expr_is_value(expr, "custom")) {
-    return format_configure_custom(expr_next(expr), formatter);
+    return format_configure_custom(ctx, expr_next(expr), formatter);
   }
 
   return errorf(
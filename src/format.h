@@ -18,6 +18,7 @@
 #include "return_code.h"
 
 namespace clip {
+struct Context;
 
 using Formatter = std::function<std::string (size_t idx, const std::string&)>;
 
@@ -30,6 +31,7 @@ Formatter format_custom(const std::vector<std::string>& values);
 Formatter format_noop();
 
 ReturnCode format_configure(
+    const Context* ctx,
     const Expr* expr,
     Formatter* formatter);
 
@@ -60,10 +60,47 @@ void draw_line(
     vec2 to,
     StrokeStyle stroke_style);
 
+/**
+ * The shaped and laid out glyphs of a single line of text. A text layout is
+ * returned when measuring a label and can be drawn directly, so that each
+ * label is only shaped once.
+ */
+struct TextLayout {
+  std::string text;
+  TextStyle style;
+  text::GlyphPlacementList glyphs;
+  Rectangle bbox;
+};
+
+ReturnCode text_layout_label(
+    const Context* ctx,
+    const std::string& text,
+    TextStyle text_style,
+    TextLayout* layout);
+
+/**
+ * Lay out a batch of labels with the same style. Large batches are shaped
+ * concurrently on multiple threads. The layouts are returned in the order of
+ * the input texts.
+ */
+ReturnCode text_layout_labels(
+    const Context* ctx,
+    const std::vector<std::string>& texts,
+    const TextStyle& text_style,
+    std::vector<TextLayout>* layouts);
+
 void draw_text(
     Context* ctx,
     draw_cmd::Text elem);
 
+ReturnCode draw_text(
+    Context* ctx,
+    const TextLayout& layout,
+    const Point& position,
+    HAlign align_x,
+    VAlign align_y,
+    double rotate);
+
 ReturnCode draw_text(
     Context* ctx,
     const std::string& text,
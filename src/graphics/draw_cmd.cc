@@ -18,8 +18,21 @@
 #include "graphics/text_layout.h"
 #include "graphics/text_support.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
 namespace clip {
 
+/**
+ * The minimum number of labels per thread when laying out a batch of labels.
+ * Smaller batches are laid out on the calling thread.
+ */
+static const size_t kTextBatchSizeMin = 64;
+
 void draw_shape(Context* ctx, draw_cmd::Shape elem) {
   ctx->drawlist.emplace_back(std::move(elem));
 }
@@ -52,14 +65,11 @@ void draw_text(Context* ctx, draw_cmd::Text elem) {
   ctx->drawlist.emplace_back(std::move(elem));
 }
 
-ReturnCode draw_text(
-    Context* ctx,
+ReturnCode text_layout_label(
+    const Context* ctx,
     const std::string& text,
-    const Point& position,
-    HAlign align_x,
-    VAlign align_y,
-    double rotate,
-    TextStyle style) {
+    TextStyle style,
+    TextLayout* layout) {
   convert_unit_typographic(ctx->dpi, ctx->font_size, &style.font_size);
 
   text::TextSpan span;
@@ -87,24 +97,158 @@ ReturnCode draw_text(
     return ERROR;
   }
 
-  Rectangle bbox;
-  std::vector<text::GlyphPlacementGroup> glyphs;
-  if (auto rc = text::text_layout_line(line, ctx->dpi, &glyphs, &bbox); !rc) {
-    return rc;
+  layout->text = text;
+  layout->style = style;
+  layout->glyphs = text::GlyphPlacementList{};
+
+  return text::text_layout_line(
+      line,
+      ctx->dpi,
+      &layout->glyphs,
+      &layout->bbox);
+}
+
+/**
+ * Large batches of labels are laid out by a pool of worker threads that is
+ * started on first use and kept until the process exits. The fonts and shapers
+ * keep their FreeType and HarfBuzz state per thread, so a persistent pool only
+ * creates that state once per worker instead of once per batch.
+ */
+struct TextLayoutPool {
+  std::mutex lock;
+  std::condition_variable wakeup;
+  std::deque<std::function<void()>> tasks;
+  size_t worker_count;
+};
+
+void text_layout_pool_work(TextLayoutPool* pool) {
+  for (;;) {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lk(pool->lock);
+      pool->wakeup.wait(lk, [pool] { return !pool->tasks.empty(); });
+      task = std::move(pool->tasks.front());
+      pool->tasks.pop_front();
+    }
+
+    task();
+  }
+}
+
+TextLayoutPool* text_layout_pool() {
+  // the pool is never destroyed since the workers are never joined; the
+  // calling thread takes part in every batch, so it starts one worker less
+  // than there are cores
+  static TextLayoutPool* pool = [] () {
+    auto pool = new TextLayoutPool();
+    pool->worker_count = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+
+    for (size_t i = 0; i < pool->worker_count; ++i) {
+      std::thread(&text_layout_pool_work, pool).detach();
+    }
+
+    return pool;
+  }();
+
+  return pool;
+}
+
+ReturnCode text_layout_labels(
+    const Context* ctx,
+    const std::vector<std::string>& texts,
+    const TextStyle& style,
+    std::vector<TextLayout>* layouts) {
+  layouts->clear();
+  layouts->resize(texts.size());
+
+  auto pool = text_layout_pool();
+  size_t thread_count = std::min(
+      pool->worker_count + 1,
+      texts.size() / kTextBatchSizeMin);
+
+  if (thread_count <= 1) {
+    for (size_t i = 0; i < texts.size(); ++i) {
+      if (auto rc = text_layout_label(ctx, texts[i], style, &(*layouts)[i]);
+          !rc) {
+        return rc;
+      }
+    }
+
+    return OK;
   }
 
-  auto offset = layout_align(bbox, position, align_x, align_y);
+  // the workers only share the read-only context and the shape cache
+  std::vector<ReturnCode> results(texts.size());
+  std::atomic<size_t> label_next(0);
+  auto work = [&] () {
+    for (;;) {
+      auto label_idx = label_next++;
+      if (label_idx >= texts.size()) {
+        return;
+      }
 
-  for (auto& gg : glyphs) {
-    for (auto& g : gg.glyphs) {
-      g.x += offset.x;
-      g.y += offset.y;
+      results[label_idx] = text_layout_label(
+          ctx,
+          texts[label_idx],
+          style,
+          &(*layouts)[label_idx]);
+    }
+  };
+
+  // tasks that only start after all labels were taken return immediately, but
+  // every task must have finished before the batch goes out of scope
+  std::mutex done_lock;
+  std::condition_variable done;
+  size_t tasks_pending = thread_count - 1;
+
+  {
+    std::lock_guard<std::mutex> lk(pool->lock);
+    for (size_t i = 0; i < thread_count - 1; ++i) {
+      pool->tasks.emplace_back([&] () {
+        work();
+
+        std::lock_guard<std::mutex> done_lk(done_lock);
+        --tasks_pending;
+        done.notify_one();
+      });
     }
   }
 
+  pool->wakeup.notify_all();
+  work();
+
+  {
+    std::unique_lock<std::mutex> lk(done_lock);
+    done.wait(lk, [&] { return tasks_pending == 0; });
+  }
+
+  for (const auto& rc : results) {
+    if (!rc) {
+      return rc;
+    }
+  }
+
+  return OK;
+}
+
+ReturnCode draw_text(
+    Context* ctx,
+    const TextLayout& layout,
+    const Point& position,
+    HAlign align_x,
+    VAlign align_y,
+    double rotate) {
+  auto offset = layout_align(layout.bbox, position, align_x, align_y);
+
   draw_cmd::Text op;
-  op.text = text;
-  op.glyphs = std::move(glyphs);
+  op.text = layout.text;
+  op.glyphs = layout.glyphs;
+
+  for (auto& g : op.glyphs.glyphs) {
+    g.x += offset.x;
+    g.y += offset.y;
+  }
 
   if (rotate) {
     op.transform = mul(
@@ -114,12 +258,28 @@ ReturnCode draw_text(
             translate2({-position.x, -position.y})));
   }
 
-  op.style = style;
+  op.style = layout.style;
   op.origin = offset;
   draw_text(ctx, op);
   return OK;
 }
 
+ReturnCode draw_text(
+    Context* ctx,
+    const std::string& text,
+    const Point& position,
+    HAlign align_x,
+    VAlign align_y,
+    double rotate,
+    TextStyle style) {
+  TextLayout layout;
+  if (auto rc = text_layout_label(ctx, text, style, &layout); !rc) {
+    return rc;
+  }
+
+  return draw_text(ctx, layout, position, align_x, align_y, rotate);
+}
+
 ReturnCode draw_text(
     Context* ctx,
     const std::string& text,
@@ -28,7 +28,7 @@ namespace clip::draw_cmd {
 
 struct Text {
   std::string text;
-  std::vector<text::GlyphPlacementGroup> glyphs;
+  text::GlyphPlacementList glyphs;
 
   // The `origin` refers to the start of the baseline
   Point origin;
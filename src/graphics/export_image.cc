@@ -12,34 +12,33 @@
  * limitations under the License.
  */
 #include "export_image.h"
+#include "context.h"
+#include "graphics/png.h"
 #include "rasterize.h"
 
-using std::bind;
-using namespace std::placeholders;
+#include <math.h>
 
 namespace clip {
 
-struct DrawOp {
-  std::function<ReturnCode (Rasterizer*)> draw_fn;
-  uint32_t draw_idx;
-};
+ReturnCode export_png(
+    const Context* ctx,
+    const ExportWriteFn& write) {
+  Rasterizer rasterizer(ceil(ctx->width), ceil(ctx->height), ctx->dpi);
+  rasterizer.clear(ctx->background_color);
 
-ReturnCode page_export_png(
-    const Page& page,
-    const DrawCommandList& drawlist,
-    std::string* buffer) {
-  Rasterizer rasterizer(page.width, page.height, page.dpi);
-  rasterizer.clear(page.background_color);
-
-  for (const auto& cmd : drawlist) {
+  for (const auto& cmd : ctx->drawlist) {
     auto rc = std::visit([&rasterizer] (const auto& c) {
       using T = std::decay_t<decltype(c)>;
       if constexpr (std::is_same_v<T, draw_cmd::Text>)
         return rasterizer.drawText(c.glyphs, c.style, c.transform);
       if constexpr (std::is_same_v<T, draw_cmd::Shape>)
-        return rasterizer.drawShape(c.path, c.stroke_style, c.fill_style);
+        return rasterizer.drawShape(
+            c.path,
+            c.stroke_style,
+            c.fill_style,
+            c.antialiasing_mode);
 
-      return ERROR;
+      return error(ERROR, "unsupported draw command");
     }, cmd);
 
     if (!rc) {
@@ -47,8 +46,23 @@ ReturnCode page_export_png(
     }
   }
 
-  *buffer = rasterizer.to_png(); // TODO
-  return OK;
+  return png_write_argb32(
+      rasterizer.data(),
+      rasterizer.width,
+      rasterizer.height,
+      rasterizer.stride(),
+      write);
+}
+
+ReturnCode export_png(
+    const Context* ctx,
+    std::string* buffer) {
+  buffer->clear();
+
+  return export_png(ctx, [buffer] (const char* data, size_t size) {
+    buffer->append(data, size);
+    return ReturnCode(OK);
+  });
 }
 
 } // namespace clip
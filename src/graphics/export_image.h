@@ -12,16 +12,21 @@
  * limitations under the License.
  */
 #pragma once
-#include <iostream>
-#include <sstream>
-#include "graphics/draw.h"
-#include "utils/outputstream.h"
+#include <string>
+#include "graphics/export_svg.h"
 
 namespace clip {
 
-ReturnCode page_export_png(
-    const Page& page,
-    const DrawCommandList& drawlist,
+/**
+ * Rasterize the drawlist of the context and encode it as a PNG image. The
+ * output is handed to the writer in chunks as it is produced.
+ */
+ReturnCode export_png(
+    const Context* ctx,
+    const ExportWriteFn& write);
+
+ReturnCode export_png(
+    const Context* ctx,
     std::string* buffer);
 
 } // namespace clip
@@ -16,17 +16,28 @@
 #include "graphics/shape_hatch.h"
 #include "graphics/draw_cmd.h"
 #include "export_svg.h"
+#include "utils/UTF8.h"
+#include "utils/stringutil.h"
+
+#include <map>
+#include <set>
+#include <tuple>
 
 using std::bind;
 using namespace std::placeholders;
 
 namespace clip {
 
+static const size_t kSVGChunkSize = 64 * 1024;
+
 struct SVGData {
   std::stringstream buffer;
   double width;
   double height;
   mat3 proj;
+  bool glyph_reuse;
+  std::map<std::tuple<const void*, double, uint32_t>, std::string> glyph_ids;
+  std::map<const void*, std::string> font_families;
 };
 
 using SVGDataRef = std::shared_ptr<SVGData>;
@@ -210,8 +221,9 @@ Status svg_shape(
   return OK;
 }
 
-Status svg_text_span_native(
+Status svg_text_element(
     const draw_cmd::Text& elem,
+    const std::string& font_opts,
     SVGDataRef svg) {
   const auto& style = elem.style;
   auto origin = mul(svg->proj, vec3{elem.origin, 1});
@@ -241,8 +253,7 @@ Status svg_text_span_native(
     << svg_attr("y", origin.y)
     << svg_attr("fill", style.color.to_hex_str(4))
     << svg_attr("font-size", style.font_size)
-    << svg_attr("font-family", style.font.font_family_css)
-    << svg_attr("font-weight", style.font.font_weight_css)
+    << font_opts
     << transform
     << ">"
     << svg_body(elem.text)
@@ -252,14 +263,191 @@ Status svg_text_span_native(
   return OK;
 }
 
+Status svg_text_span_native(
+    const draw_cmd::Text& elem,
+    SVGDataRef svg) {
+  const auto& font = elem.style.font;
+
+  return svg_text_element(
+      elem,
+      svg_attr("font-family", font.stack->font_family_css) +
+      svg_attr("font-weight", font.stack->font_weight_css),
+      svg);
+}
+
+/**
+ * Return the font of a text element that is drawn with glyph outlines using
+ * only one font or nullptr if the element uses the native font stack, is empty
+ * or mixes fonts.
+ */
+const FontRef* svg_text_font(const draw_cmd::Text& elem) {
+  const auto& style = elem.style;
+  const auto& runs = elem.glyphs.runs;
+
+  if (!style.font.stack->font_family_css.empty() || runs.empty()) {
+    return nullptr;
+  }
+
+  for (const auto& run : runs) {
+    if (run.font != runs[0].font) {
+      return nullptr;
+    }
+  }
+
+  return &style.font.stack->fonts[runs[0].font];
+}
+
+bool svg_text_codepoints(
+    const std::string& text,
+    std::set<uint32_t>* codepoints) {
+  const char* cur = text.data();
+  const char* end = text.data() + text.size();
+
+  try {
+    while (cur < end) {
+      codepoints->insert(UTF8::nextCodepoint(&cur, end));
+    }
+  } catch (...) {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Embed a subset of each font that is used to draw text with glyph outlines
+ * as a @font-face rule, so that the text can be written as <text> elements.
+ * Each subset only contains the characters that are drawn using the font.
+ * Fonts that can not be subset are skipped and the text using them is drawn
+ * with glyph outlines instead.
+ */
+ReturnCode svg_fonts_embed(const Context* ctx, SVGDataRef svg) {
+  std::map<const void*, std::pair<FontRef, std::set<uint32_t>>> fonts;
+
+  for (const auto& cmd : ctx->drawlist) {
+    auto text = std::get_if<draw_cmd::Text>(&cmd);
+    if (!text) {
+      continue;
+    }
+
+    auto font = svg_text_font(*text);
+    if (!font) {
+      continue;
+    }
+
+    auto& font_codepoints = fonts[font->get()];
+    font_codepoints.first = *font;
+
+    if (!svg_text_codepoints(text->text, &font_codepoints.second)) {
+      return errorf(ERROR, "invalid UTF-8 text: {}", text->text);
+    }
+  }
+
+  if (fonts.empty()) {
+    return OK;
+  }
+
+  std::string font_css;
+  for (const auto& font : fonts) {
+    std::string font_data;
+    if (!font_subset(font.second.first, font.second.second, &font_data)) {
+      continue;
+    }
+
+    auto font_family = fmt::format("clip-font-{}", svg->font_families.size());
+    svg->font_families[font.first] = font_family;
+
+    font_css += fmt::format(
+        "@font-face {{ "
+        "font-family: \"{}\"; "
+        "src: url(data:font/ttf;base64,{}); "
+        "}}",
+        font_family,
+        StringUtil::base64Encode(font_data.data(), font_data.size()));
+  }
+
+  if (!font_css.empty()) {
+    svg->buffer
+        << "  "
+        << "<defs><style>"
+        << font_css
+        << "</style></defs>"
+        << "\n";
+  }
+
+  return OK;
+}
+
+/**
+ * Write each glyph outline once into a <defs> element and reference it with a
+ * <use> element for every occurrence. The definition is written just before
+ * the first use so that the output can be streamed.
+ */
+Status svg_text_glyph_use(
+    const FontRef& font,
+    const text::GlyphPlacement& g,
+    const mat3& gt,
+    const TextStyle& style,
+    double dpi,
+    SVGDataRef svg) {
+  auto& glyph_id = svg->glyph_ids[
+      std::make_tuple(font.get(), style.font_size, g.codepoint)];
+
+  if (glyph_id.empty()) {
+    Path gp;
+    auto rc = font_get_glyph_path(
+        font,
+        style.font_size,
+        dpi,
+        g.codepoint,
+        &gp);
+
+    if (!rc) {
+      return ERROR;
+    }
+
+    glyph_id = fmt::format("g{}", svg->glyph_ids.size() - 1);
+
+    svg->buffer
+        << "  "
+        << "<defs><path"
+        << svg_attr("id", glyph_id)
+        << svg_attr("d", svg_path_data(gp))
+        << "/></defs>"
+        << "\n";
+  }
+
+  svg->buffer
+      << "  "
+      << "<use"
+      << svg_attr("href", "#" + glyph_id)
+      << svg_attr("fill", style.color.to_hex_str(4))
+      << svg_attr(
+            "transform",
+            fmt::format(
+                "matrix({} {} {} {} {} {})",
+                gt.a,
+                gt.d,
+                gt.b,
+                gt.e,
+                gt.c,
+                gt.f))
+      << "/>"
+      << "\n";
+
+  return OK;
+}
+
 Status svg_text_span_embed(
     const draw_cmd::Text& elem,
     double dpi,
     SVGDataRef svg) {
   const auto& style = elem.style;
 
-  for (const auto& gg : elem.glyphs) {
-    for (const auto& g : gg.glyphs) {
+  for (const auto& run : elem.glyphs.runs) {
+    for (auto i = run.glyph_begin; i < run.glyph_end; ++i) {
+      const auto& g = elem.glyphs.glyphs[i];
+      const auto& font = style.font.stack->fonts[run.font];
       auto gt = translate2({g.x, g.y});
       if (elem.transform) {
         gt = mul(*elem.transform, gt);
@@ -267,9 +455,18 @@ Status svg_text_span_embed(
 
       gt = mul(svg->proj, gt);
 
+      if (svg->glyph_reuse) {
+        auto rc = svg_text_glyph_use(font, g, gt, style, dpi, svg);
+        if (!rc) {
+          return rc;
+        }
+
+        continue;
+      }
+
       Path gp;
       auto rc = font_get_glyph_path(
-          g.font,
+          font,
           elem.style.font_size,
           dpi,
           g.codepoint,
@@ -296,11 +493,21 @@ Status svg_text_span(
     const draw_cmd::Text& elem,
     double dpi,
     SVGDataRef svg) {
-  if (elem.style.font.font_family_css.empty()) {
-    return svg_text_span_embed(elem, dpi, svg);
-  } else {
+  if (!elem.style.font.stack->font_family_css.empty()) {
     return svg_text_span_native(elem, svg);
   }
+
+  if (auto font = svg_text_font(elem); font) {
+    auto font_family = svg->font_families.find(font->get());
+    if (font_family != svg->font_families.end()) {
+      return svg_text_element(
+          elem,
+          svg_attr("font-family", font_family->second),
+          svg);
+    }
+  }
+
+  return svg_text_span_embed(elem, dpi, svg);
 }
 
 struct SVGDrawOp {
@@ -308,13 +515,47 @@ struct SVGDrawOp {
   uint32_t draw_idx;
 };
 
+ReturnCode svg_flush(SVGDataRef svg, const ExportWriteFn& write) {
+  auto chunk = svg->buffer.str();
+  svg->buffer.str("");
+
+  if (chunk.empty()) {
+    return OK;
+  }
+
+  return write(chunk.data(), chunk.size());
+}
+
 ReturnCode export_svg(
     const Context* ctx,
-    std::string* buffer) {
+    const ExportWriteFn& write) {
   auto svg = std::make_shared<SVGData>();
   svg->width = ctx->width;
   svg->height = ctx->height;
   svg->proj = mul(translate2({0, ctx->height}), scale2({1, -1}));
+  svg->glyph_reuse = ctx->svg_glyph_reuse;
+
+  svg->buffer
+    << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+    << fmt::format("<!-- Generated by clip v{} (clip-lang.org) -->\n", CLIP_VERSION)
+
+    << "<svg"
+      << svg_attr("xmlns", "http://www.w3.org/2000/svg")
+      << svg_attr("width", ctx->width)
+      << svg_attr("height", ctx->height)
+      << ">\n"
+    << "  <rect"
+      << svg_attr("width", ctx->width)
+      << svg_attr("height", ctx->height)
+      << svg_attr("fill", ctx->background_color.to_hex_str())
+      << svg_attr("fill-opacity", ctx->background_color.component(3))
+      << "/>\n";
+
+  if (ctx->svg_font_embed) {
+    if (auto rc = svg_fonts_embed(ctx, svg); !rc) {
+      return rc;
+    }
+  }
 
   for (const auto& cmd : ctx->drawlist) {
     auto rc = std::visit([svg, ctx] (const auto& c) {
@@ -330,30 +571,29 @@ ReturnCode export_svg(
     if (!rc) {
       return rc;
     }
-  }
 
-  std::stringstream svg_doc;
+    // hand the output to the writer in chunks so that the whole document is
+    // never held in memory at once
+    if (svg->buffer.tellp() >= std::streampos(kSVGChunkSize)) {
+      if (auto rc = svg_flush(svg, write); !rc) {
+        return rc;
+      }
+    }
+  }
 
-  svg_doc
-    << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
-    << fmt::format("<!-- Generated by clip v{} (clip-lang.org) -->\n", CLIP_VERSION)
+  svg->buffer << "</svg>";
+  return svg_flush(svg, write);
+}
 
-    << "<svg"
-      << svg_attr("xmlns", "http://www.w3.org/2000/svg")
-      << svg_attr("width", ctx->width)
-      << svg_attr("height", ctx->height)
-      << ">\n"
-    << "  <rect"
-      << svg_attr("width", ctx->width)
-      << svg_attr("height", ctx->height)
-      << svg_attr("fill", ctx->background_color.to_hex_str())
-      << svg_attr("fill-opacity", ctx->background_color.component(3))
-      << "/>\n"
-    << svg->buffer.str()
-    << "</svg>";
+ReturnCode export_svg(
+    const Context* ctx,
+    std::string* buffer) {
+  buffer->clear();
 
-  *buffer = svg_doc.str();
-  return OK;
+  return export_svg(ctx, [buffer] (const char* data, size_t size) {
+    buffer->append(data, size);
+    return ReturnCode(OK);
+  });
 }
 
 } // namespace clip
@@ -19,6 +19,15 @@
 
 namespace clip {
 
+/**
+ * Receives the output of an export in chunks as it is produced
+ */
+using ExportWriteFn = std::function<ReturnCode (const char* data, size_t size)>;
+
+ReturnCode export_svg(
+    const Context* ctx,
+    const ExportWriteFn& write);
+
 ReturnCode export_svg(
     const Context* ctx,
     std::string* buffer);
@@ -0,0 +1,277 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "graphics/font_cache.h"
+#include "utils/fileutil.h"
+#include "utils/stringutil.h"
+
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace clip {
+
+static const char kFontCacheVersion[] = "clip-font-cache 1";
+
+struct FontCache {
+  std::mutex lock;
+  bool loaded = false;
+  std::string path;
+  std::map<std::string, std::string> stamps;
+  std::map<std::string, std::vector<FontCacheEntry>> patterns;
+};
+
+FontCache* font_cache() {
+  static FontCache cache;
+  return &cache;
+}
+
+std::string font_cache_path() {
+  if (auto path = getenv("CLIP_FONT_CACHE"); path) {
+    return path;
+  }
+
+  if (auto path = getenv("XDG_CACHE_HOME"); path && *path) {
+    return std::string(path) + "/clip/fonts.cache";
+  }
+
+  if (auto path = getenv("HOME"); path && *path) {
+    return std::string(path) + "/.cache/clip/fonts.cache";
+  }
+
+  return "";
+}
+
+std::string font_cache_stamp(const std::string& path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) < 0) {
+    return "-";
+  }
+
+#if defined(__APPLE__)
+  const auto& mtime = st.st_mtimespec;
+#else
+  const auto& mtime = st.st_mtim;
+#endif
+
+  return fmt::format("{}.{}", mtime.tv_sec, mtime.tv_nsec);
+}
+
+/**
+ * The cache file is a line based text file. Paths and patterns are always
+ * stored at the end of a line so that they may contain spaces.
+ *
+ *   clip-font-cache 1
+ *   stamp <mtime> <path>
+ *   pattern <pattern>
+ *   font <face_index> <path>
+ *   coverage <begin>-<end> <begin>-<end>...
+ */
+bool font_cache_read(FontCache* cache) {
+  std::string data;
+  if (!read_file(cache->path, &data)) {
+    return false;
+  }
+
+  auto lines = StringUtil::split(data, "\n");
+  if (lines.empty() || lines[0] != kFontCacheVersion) {
+    return false;
+  }
+
+  std::vector<FontCacheEntry>* pattern = nullptr;
+  for (size_t i = 1; i < lines.size(); ++i) {
+    const auto& line = lines[i];
+    auto sep = line.find(' ');
+    auto key = line.substr(0, sep);
+    auto value = sep == std::string::npos ? "" : line.substr(sep + 1);
+
+    if (key == "stamp") {
+      auto stamp_sep = value.find(' ');
+      if (stamp_sep == std::string::npos) {
+        return false;
+      }
+
+      auto stamp_path = value.substr(stamp_sep + 1);
+      auto stamp = value.substr(0, stamp_sep);
+
+      // fonts or configuration changed; the cache is stale
+      if (font_cache_stamp(stamp_path) != stamp) {
+        return false;
+      }
+
+      cache->stamps[stamp_path] = stamp;
+      continue;
+    }
+
+    if (key == "pattern") {
+      pattern = &cache->patterns[value];
+      pattern->clear();
+      continue;
+    }
+
+    if (key == "font" && pattern) {
+      auto index_sep = value.find(' ');
+      if (index_sep == std::string::npos) {
+        return false;
+      }
+
+      FontCacheEntry font;
+      font.face_index = std::atoi(value.substr(0, index_sep).c_str());
+      font.file = value.substr(index_sep + 1);
+      font.coverage_known = false;
+      pattern->emplace_back(std::move(font));
+      continue;
+    }
+
+    if (key == "coverage" && pattern && !pattern->empty()) {
+      auto& font = pattern->back();
+      font.coverage_known = true;
+
+      std::istringstream ranges(value);
+      for (std::string range; ranges >> range; ) {
+        uint32_t begin;
+        uint32_t end;
+        if (sscanf(range.c_str(), "%x-%x", &begin, &end) != 2) {
+          return false;
+        }
+
+        font.coverage.emplace_back(begin, end);
+      }
+
+      continue;
+    }
+
+    if (!line.empty()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void font_cache_write(const FontCache* cache) {
+  std::string data = kFontCacheVersion;
+  data += "\n";
+
+  for (const auto& stamp : cache->stamps) {
+    data += fmt::format("stamp {} {}\n", stamp.second, stamp.first);
+  }
+
+  for (const auto& pattern : cache->patterns) {
+    data += fmt::format("pattern {}\n", pattern.first);
+
+    for (const auto& font : pattern.second) {
+      data += fmt::format("font {} {}\n", font.face_index, font.file);
+
+      if (font.coverage_known) {
+        data += "coverage";
+        for (const auto& range : font.coverage) {
+          data += fmt::format(" {:x}-{:x}", range.first, range.second);
+        }
+        data += "\n";
+      }
+    }
+  }
+
+  auto dir_end = cache->path.rfind('/');
+  if (dir_end != std::string::npos && dir_end > 0) {
+    try {
+      FileUtil::mkdir_p(cache->path.substr(0, dir_end));
+    } catch (...) {
+      return;
+    }
+  }
+
+  // write to a temporary file first so that concurrent readers never see a
+  // partially written cache
+  auto path_tmp = fmt::format("{}.{}", cache->path, getpid());
+  if (!write_file(path_tmp, data)) {
+    unlink(path_tmp.c_str());
+    return;
+  }
+
+  if (rename(path_tmp.c_str(), cache->path.c_str()) < 0) {
+    unlink(path_tmp.c_str());
+  }
+}
+
+void font_cache_load(FontCache* cache) {
+  if (cache->loaded) {
+    return;
+  }
+
+  cache->loaded = true;
+  cache->path = font_cache_path();
+
+  if (cache->path.empty() || !font_cache_read(cache)) {
+    cache->stamps.clear();
+    cache->patterns.clear();
+  }
+}
+
+bool font_cache_lookup(
+    const std::string& pattern,
+    std::vector<FontCacheEntry>* fonts) {
+  auto cache = font_cache();
+
+  std::lock_guard<std::mutex> lk(cache->lock);
+  font_cache_load(cache);
+
+  auto entry = cache->patterns.find(pattern);
+  if (entry == cache->patterns.end()) {
+    return false;
+  }
+
+  *fonts = entry->second;
+  return true;
+}
+
+void font_cache_store(
+    const std::string& pattern,
+    const std::vector<FontCacheEntry>& fonts,
+    const std::vector<std::string>& stamp_paths) {
+  auto cache = font_cache();
+
+  std::lock_guard<std::mutex> lk(cache->lock);
+  font_cache_load(cache);
+
+  if (cache->path.empty()) {
+    return;
+  }
+
+  // if any of the paths changed since the cache was loaded, the existing
+  // entries are stale and are dropped
+  for (const auto& path : stamp_paths) {
+    auto stamp = font_cache_stamp(path);
+    auto stamp_iter = cache->stamps.find(path);
+    if (stamp_iter != cache->stamps.end() && stamp_iter->second != stamp) {
+      cache->stamps.clear();
+      cache->patterns.clear();
+      break;
+    }
+  }
+
+  for (const auto& path : stamp_paths) {
+    cache->stamps[path] = font_cache_stamp(path);
+  }
+
+  cache->patterns[pattern] = fonts;
+  font_cache_write(cache);
+}
+
+} // namespace clip
+
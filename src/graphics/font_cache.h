@@ -0,0 +1,58 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace clip {
+
+using FontCoverage = std::vector<std::pair<uint32_t, uint32_t>>;
+
+/**
+ * A font face that was resolved using fontconfig
+ */
+struct FontCacheEntry {
+  std::string file;
+  int face_index;
+  bool coverage_known;
+  FontCoverage coverage;
+};
+
+/**
+ * The font cache is a persistent on-disk cache of fontconfig lookups. It maps
+ * font patterns to the resolved list of faces so that fontconfig does not need
+ * to be initialized on a warm start.
+ *
+ * Each stored lookup records the paths of the fontconfig configuration files
+ * and font directories. The whole cache is discarded if the modification time
+ * of any of these paths has changed, i.e. when fonts were installed or removed
+ * or the configuration was changed.
+ *
+ * The cache is stored in `$XDG_CACHE_HOME/clip/fonts.cache` or
+ * `$HOME/.cache/clip/fonts.cache`. The location can be overridden with the
+ * `CLIP_FONT_CACHE` environment variable; setting it to an empty string
+ * disables the cache.
+ */
+bool font_cache_lookup(
+    const std::string& pattern,
+    std::vector<FontCacheEntry>* fonts);
+
+void font_cache_store(
+    const std::string& pattern,
+    const std::vector<FontCacheEntry>& fonts,
+    const std::vector<std::string>& stamp_paths);
+
+} // namespace clip
+
@@ -12,17 +12,33 @@
  * limitations under the License.
  */
 #include "font_lookup.h"
+#include "font_cache.h"
 #include "sexpr.h"
 #include "graphics/geometry.h"
 #include "utils/fileutil.h"
 
+#include <algorithm>
 #include <iostream>
 #include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <fontconfig/fontconfig.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
+#include FT_SIZES_H
+#include <harfbuzz/hb.h>
+#include <harfbuzz/hb-subset.h>
 
 using namespace std::placeholders;
 using std::bind;
@@ -35,26 +51,240 @@ const std::string_view DEFAULT_FONT_PATTERN_CSS =
 const char* const DEFAULT_FONT_PATTERN_FC =
     "Arial,Helvetica,Helvetica Neue:style=Regular,Roman";
 
-struct FontStorage {
-  FontStorage() : ft(nullptr), ft_font(nullptr) {}
+/**
+ * A font is an immutable reference to a face in a font file. All fonts are
+ * kept in a process-wide registry so that every context and thread uses the
+ * same font objects. The registry is never cleared, so a font object stays
+ * valid for the lifetime of the process.
+ *
+ * FreeType handles must not be used from more than one thread at a time, so
+ * the FT_Library and FT_Face handles are created lazily for each thread that
+ * uses a font. All faces are created from read-only memory mappings of the
+ * font files. There is only one mapping per file, which is shared by all
+ * threads and all faces of a font collection, and the mapped pages are shared
+ * with other processes through the page cache.
+ *
+ * Fonts that were found using fontconfig also carry their unicode coverage as
+ * a sorted list of codepoint ranges, so that the font fallback can skip fonts
+ * without ever opening them.
+ */
+struct FontStorage : public FontCacheEntry {};
+
+struct FontFileMapping {
+  FontFileMapping() : data(nullptr), size(0) {}
+  ~FontFileMapping() {
+    if (data) {
+      munmap(data, size);
+    }
+  }
+
+  void* data;
+  size_t size;
+};
+
+using FontFileMappingRef = std::shared_ptr<const FontFileMapping>;
+
+using FontStackKey = std::tuple<
+    std::vector<const FontStorage*>,
+    std::string,
+    double>;
+
+struct FontRegistry {
+  std::mutex lock;
+  std::map<std::pair<std::string, int>, FontRef> fonts;
+  std::map<FontStackKey, std::unique_ptr<const FontStack>> stacks;
+  std::unordered_map<std::string, FontFileMappingRef> files;
+  std::vector<FontRef> defaults;
+  bool defaults_loaded = false;
+  bool load_disabled = false;
+  FT_Library ft_owned = nullptr;
+};
+
+/**
+ * Each face keeps one FreeType size object per font size and resolution so
+ * that the scaling does not need to be recomputed whenever a font is used with
+ * a different size. The size objects are released together with their face.
+ */
+struct FontThreadFace {
+  FT_Face face;
+  FT_Size size_default;
+  std::map<std::pair<FT_F26Dot6, FT_UInt>, FT_Size> sizes;
+};
+
+struct FontThreadState {
+  FontThreadState() : ft(nullptr) {}
+  ~FontThreadState() {
+    for (const auto& face : faces) {
+      if (face.second.face) {
+        FT_Done_Face(face.second.face);
+      }
+    }
+
+    if (ft) {
+      FT_Done_FreeType(ft);
+    }
+  }
+
   FT_Library ft;
-  FT_Face ft_font;
+  std::unordered_map<const FontStorage*, FontThreadFace> faces;
 };
 
-void font_close(FontStorage* font) {
-  if (font->ft_font) {
-    FT_Done_Face(font->ft_font);
+FontRegistry* font_registry() {
+  static FontRegistry registry;
+  return &registry;
+}
+
+const FontStack* font_stack_intern(const FontStack& stack) {
+  auto registry = font_registry();
+
+  FontStackKey key;
+  for (const auto& font : stack.fonts) {
+    std::get<0>(key).push_back(font.get());
   }
 
-  if (font->ft) {
-    FT_Done_FreeType(font->ft);
+  std::get<1>(key) = stack.font_family_css;
+  std::get<2>(key) = stack.font_weight_css;
+
+  std::lock_guard<std::mutex> lk(registry->lock);
+  auto& stack_interned = registry->stacks[key];
+  if (!stack_interned) {
+    stack_interned = std::make_unique<const FontStack>(stack);
   }
 
-  delete font;
+  return stack_interned.get();
+}
+
+FontInfo::FontInfo() {
+  static const FontStack* stack_empty = font_stack_intern(FontStack{{}, "", 0});
+  stack = stack_empty;
+}
+
+FontThreadState* font_thread_state() {
+  thread_local FontThreadState state;
+  return &state;
+}
+
+ReturnCode font_map_file(
+    const std::string& path,
+    FontFileMappingRef* mapping) {
+  auto registry = font_registry();
+
+  std::lock_guard<std::mutex> lk(registry->lock);
+  auto& file = registry->files[path];
+  if (file) {
+    *mapping = file;
+    return OK;
+  }
+
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return errorf(ERROR, "unable to open font file '{}': {}", path, strerror(errno));
+  }
+
+  struct stat fd_stat;
+  if (fstat(fd, &fd_stat) < 0 || fd_stat.st_size == 0) {
+    close(fd);
+    return errorf(ERROR, "unable to read font file '{}'", path);
+  }
+
+  auto data = mmap(nullptr, fd_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (data == MAP_FAILED) {
+    return errorf(ERROR, "unable to map font file '{}': {}", path, strerror(errno));
+  }
+
+  auto file_new = std::make_shared<FontFileMapping>();
+  file_new->data = data;
+  file_new->size = fd_stat.st_size;
+
+  file = file_new;
+  *mapping = file;
+  return OK;
+}
+
+FontThreadFace* font_get_thread_face(const FontRef& font) {
+  auto state = font_thread_state();
+
+  auto face_iter = state->faces.find(font.get());
+  if (face_iter != state->faces.end()) {
+    return &face_iter->second;
+  }
+
+  if (!state->ft && FT_Init_FreeType(&state->ft) != 0) {
+    state->ft = nullptr;
+    return nullptr;
+  }
+
+  // a face that failed to open is remembered as nullptr so that it is not
+  // retried on every call. the file mappings are never released, so the
+  // memory stays valid for as long as the face exists
+  FontFileMappingRef file;
+  FT_Face face = nullptr;
+  if (font_map_file(font->file, &file)) {
+    auto rc = FT_New_Memory_Face(
+        state->ft,
+        static_cast<const FT_Byte*>(file->data),
+        file->size,
+        font->face_index,
+        &face);
+
+    if (rc) {
+      face = nullptr;
+    }
+  }
+
+  auto& thread_face = state->faces[font.get()];
+  thread_face.face = face;
+  thread_face.size_default = face ? face->size : nullptr;
+  return &thread_face;
 }
 
 void* font_get_freetype(FontRef font) {
-  return font->ft_font;
+  auto thread_face = font_get_thread_face(font);
+  if (!thread_face || !thread_face->face) {
+    return nullptr;
+  }
+
+  // restore the default size in case a sized face was used before
+  if (thread_face->face->size != thread_face->size_default) {
+    FT_Activate_Size(thread_face->size_default);
+  }
+
+  return thread_face->face;
+}
+
+void* font_get_freetype_sized(FontRef font, double font_size, double dpi) {
+  auto thread_face = font_get_thread_face(font);
+  if (!thread_face || !thread_face->face) {
+    return nullptr;
+  }
+
+  auto font_size_ft = FT_F26Dot6(font_size * (72.0 / dpi) * 64);
+  auto font_dpi_ft = FT_UInt(dpi);
+
+  auto& size = thread_face->sizes[std::make_pair(font_size_ft, font_dpi_ft)];
+  if (size) {
+    FT_Activate_Size(size);
+    return thread_face->face;
+  }
+
+  if (FT_New_Size(thread_face->face, &size)) {
+    thread_face->sizes.erase(std::make_pair(font_size_ft, font_dpi_ft));
+    return nullptr;
+  }
+
+  FT_Activate_Size(size);
+  if (FT_Set_Char_Size(
+        thread_face->face,
+        0,
+        font_size_ft,
+        font_dpi_ft,
+        font_dpi_ft)) {
+    return nullptr;
+  }
+
+  return thread_face->face;
 }
 
 enum class GlyphPointType : char { ON = 'x', OFF2 = '2', OFF3 = '3' };
@@ -64,7 +294,82 @@ struct GlyphContour {
   std::vector<GlyphPointType> tags;
 };
 
-ReturnCode font_get_glyph_path(
+bool font_has_codepoint(const FontRef& font, uint32_t codepoint) {
+  // fonts that were loaded from a file have no coverage information, so their
+  // character map is checked instead
+  if (!font->coverage_known) {
+    auto ft_font = static_cast<FT_Face>(font_get_freetype(font));
+    return ft_font && FT_Get_Char_Index(ft_font, codepoint) != 0;
+  }
+
+  auto range = std::upper_bound(
+      font->coverage.begin(),
+      font->coverage.end(),
+      std::make_pair(codepoint, std::numeric_limits<uint32_t>::max()));
+
+  if (range == font->coverage.begin()) {
+    return false;
+  }
+
+  --range;
+  return codepoint >= range->first && codepoint <= range->second;
+}
+
+FontRef font_register(const FontCacheEntry& font) {
+  auto registry = font_registry();
+  auto font_key = std::make_pair(font.file, font.face_index);
+
+  std::lock_guard<std::mutex> lk(registry->lock);
+  auto& font_ref = registry->fonts[font_key];
+  if (!font_ref) {
+    font_ref = std::make_shared<FontStorage>();
+    static_cast<FontCacheEntry&>(*font_ref) = font;
+  }
+
+  return font_ref;
+}
+
+/**
+ * Faces that are owned by the caller are created in a separate library that is
+ * guarded by the registry lock, so that they can be released from any thread.
+ * The library is never destroyed since faces may still be released while the
+ * process exits.
+ */
+void* font_open_freetype(FontRef font) {
+  FontFileMappingRef file;
+  if (!font_map_file(font->file, &file)) {
+    return nullptr;
+  }
+
+  auto registry = font_registry();
+  std::lock_guard<std::mutex> lk(registry->lock);
+  if (!registry->ft_owned && FT_Init_FreeType(&registry->ft_owned) != 0) {
+    registry->ft_owned = nullptr;
+    return nullptr;
+  }
+
+  FT_Face face;
+  auto rc = FT_New_Memory_Face(
+      registry->ft_owned,
+      static_cast<const FT_Byte*>(file->data),
+      file->size,
+      font->face_index,
+      &face);
+
+  if (rc) {
+    return nullptr;
+  }
+
+  return face;
+}
+
+void font_close_freetype(void* face) {
+  auto registry = font_registry();
+  std::lock_guard<std::mutex> lk(registry->lock);
+  FT_Done_Face(static_cast<FT_Face>(face));
+}
+
+ReturnCode font_load_glyph_path(
     FontRef font,
     double font_size,
     double dpi,
@@ -72,18 +377,20 @@ ReturnCode font_get_glyph_path(
     Path* path) {
   *path = Path{};
 
-  // load the glyph using freetype
-  auto font_size_ft = font_size * (72.0 / dpi) * 64;
-  if (FT_Set_Char_Size(font->ft_font, 0, font_size_ft, dpi, dpi)) {
+  auto ft_font = static_cast<FT_Face>(
+      font_get_freetype_sized(font, font_size, dpi));
+
+  if (!ft_font) {
     return ERROR;
   }
 
-  if (FT_Load_Glyph(font->ft_font, codepoint, FT_LOAD_DEFAULT)) {
+  // load the glyph using freetype
+  if (FT_Load_Glyph(ft_font, codepoint, FT_LOAD_DEFAULT)) {
     return ERROR;
   }
 
   FT_Glyph glyph;
-  if (FT_Get_Glyph(font->ft_font->glyph, &glyph)) {
+  if (FT_Get_Glyph(ft_font->glyph, &glyph)) {
     return ERROR;
   }
 
@@ -237,127 +544,383 @@ ReturnCode font_get_glyph_path(
   return OK;
 }
 
-ReturnCode font_load(const std::string& font_file, FontRef* font_ref) {
-  auto font = FontRef(new FontStorage, bind(&font_close, _1));
+/**
+ * Glyph outlines are cached process-wide by font, size and glyph so that a
+ * glyph that is drawn many times is only loaded from FreeType once. The cache
+ * is cleared when it is full.
+ */
+static const size_t kGlyphPathCacheSize = 65536;
 
-  if (FT_Init_FreeType(&font->ft) != 0) {
-    return ERROR;
+struct GlyphPathCache {
+  using Key = std::tuple<const FontStorage*, double, double, uint32_t>;
+
+  std::mutex lock;
+  std::map<Key, Path> paths;
+};
+
+GlyphPathCache* font_glyph_path_cache() {
+  static GlyphPathCache cache;
+  return &cache;
+}
+
+ReturnCode font_get_glyph_path(
+    FontRef font,
+    double font_size,
+    double dpi,
+    uint32_t codepoint,
+    Path* path) {
+  auto cache = font_glyph_path_cache();
+  auto key = std::make_tuple(font.get(), font_size, dpi, codepoint);
+
+  {
+    std::lock_guard<std::mutex> lk(cache->lock);
+    auto iter = cache->paths.find(key);
+    if (iter != cache->paths.end()) {
+      *path = iter->second;
+      return OK;
+    }
   }
 
-  if (FT_New_Face(font->ft, font_file.c_str(), 0, &font->ft_font) != 0) {
-    return ERROR;
+  auto rc = font_load_glyph_path(font, font_size, dpi, codepoint, path);
+  if (!rc) {
+    return rc;
+  }
+
+  std::lock_guard<std::mutex> lk(cache->lock);
+  if (cache->paths.size() >= kGlyphPathCacheSize) {
+    cache->paths.clear();
   }
 
-  *font_ref = std::move(font);
+  cache->paths.emplace(key, *path);
   return OK;
 }
 
-ReturnCode font_load_best(
-    const std::string& font_pattern,
-    FontInfo* font_info) {
-  std::string font_file;
+ReturnCode font_load(const std::string& font_file, FontRef* font_ref) {
+  FontCacheEntry font_entry;
+  font_entry.file = font_file;
+  font_entry.face_index = 0;
+  font_entry.coverage_known = false;
+
+  // the font is registered before it is opened: the per-thread faces are keyed
+  // by the address of the font, so only fonts that are kept alive by the
+  // registry may be opened. a font that fails to open stays registered and
+  // reports the same error whenever it is loaded again
+  auto font = font_register(font_entry);
+
+  // open the face on the calling thread to make sure that the font is usable
+  if (!font_get_freetype(font)) {
+    return error(ERROR, "unable to open font face");
+  }
 
-  if (font_pattern.empty()) {
-    return error(ERROR, "unable to load font: empty font pattern");
+  *font_ref = font;
+  return OK;
+}
+
+void font_read_coverage(FcCharSet* charset, FontCoverage* coverage) {
+  FcChar32 map[FC_CHARSET_MAP_SIZE];
+  FcChar32 next;
+
+  auto base = FcCharSetFirstPage(charset, map, &next);
+  while (base != FC_CHARSET_DONE) {
+    for (size_t i = 0; i < FC_CHARSET_MAP_SIZE; ++i) {
+      for (size_t bit = 0; bit < 32; ++bit) {
+        if (!(map[i] & (1u << bit))) {
+          continue;
+        }
+
+        uint32_t codepoint = base + i * 32 + bit;
+        if (!coverage->empty() && coverage->back().second + 1 == codepoint) {
+          coverage->back().second = codepoint;
+        } else {
+          coverage->emplace_back(codepoint, codepoint);
+        }
+      }
+    }
+
+    base = FcCharSetNextPage(charset, map, &next);
   }
+}
 
-  if (font_pattern[0] == '/' ||
-      StringUtil::endsWith(font_pattern, ".otf") ||
-      StringUtil::endsWith(font_pattern, ".ttf")) { // TODO improved filename detection
-    font_file = font_pattern;
+bool font_read_pattern(FcPattern* fc_font, FontCacheEntry* font) {
+  char* fc_file = nullptr;
+  auto fc_file_rc = FcPatternGetString(
+      fc_font,
+      FC_FILE,
+      0,
+      reinterpret_cast<FcChar8**>(&fc_file));
+
+  if (fc_file_rc != FcResultMatch) {
+    return false;
   }
 
-  // lookup using fontconfig
-  if (font_file.empty()) {
-    auto fc_config = FcInitLoadConfigAndFonts();
-    auto fc_pattern = FcNameParse((FcChar8*) font_pattern.c_str());
+  font->file = fc_file;
+  font->face_index = 0;
+  font->coverage_known = false;
+  font->coverage.clear();
 
-    FcDefaultSubstitute(fc_pattern);
-    FcConfigSubstitute(fc_config, fc_pattern, FcMatchPattern);
+  FcPatternGetInteger(fc_font, FC_INDEX, 0, &font->face_index);
 
-    FcResult fc_res;
-    auto fc_font = FcFontMatch(fc_config, fc_pattern, &fc_res);
-    if (fc_font && fc_res == FcResultMatch) {
-      char* fc_file;
-      if (FcPatternGetString(fc_font, FC_FILE, 0, (FcChar8**) &fc_file) == FcResultMatch) {
-        font_file = std::string(fc_file);
-      }
+  FcCharSet* fc_charset;
+  if (FcPatternGetCharSet(fc_font, FC_CHARSET, 0, &fc_charset) == FcResultMatch) {
+    font_read_coverage(fc_charset, &font->coverage);
+    font->coverage_known = true;
+  }
+
+  return true;
+}
+
+/**
+ * Collect the fontconfig configuration files and font directories. The font
+ * cache is invalidated when any of them changes.
+ */
+void font_read_config_stamps(
+    FcConfig* fc_config,
+    std::vector<std::string>* paths) {
+  for (auto fc_list : {
+      FcConfigGetConfigFiles(fc_config),
+      FcConfigGetFontDirs(fc_config) }) {
+    if (!fc_list) {
+      continue;
+    }
 
-      FcPatternDestroy(fc_font);
+    while (auto fc_path = FcStrListNext(fc_list)) {
+      paths->emplace_back(reinterpret_cast<const char*>(fc_path));
     }
 
-    FcPatternDestroy(fc_pattern);
-    FcConfigDestroy(fc_config);
+    FcStrListDone(fc_list);
   }
+}
+
+ReturnCode font_find_best(
+    const std::string& font_pattern,
+    FontCacheEntry* font) {
+  auto cache_key = "match:" + font_pattern;
+
+  std::vector<FontCacheEntry> cached;
+  if (font_cache_lookup(cache_key, &cached) && cached.size() == 1) {
+    *font = cached[0];
+    return OK;
+  }
+
+  auto fc_config = FcInitLoadConfigAndFonts();
+  auto fc_pattern = FcNameParse((FcChar8*) font_pattern.c_str());
+
+  FcDefaultSubstitute(fc_pattern);
+  FcConfigSubstitute(fc_config, fc_pattern, FcMatchPattern);
+
+  bool found = false;
+  FcResult fc_res;
+  auto fc_font = FcFontMatch(fc_config, fc_pattern, &fc_res);
+  if (fc_font && fc_res == FcResultMatch) {
+    found = font_read_pattern(fc_font, font);
+  }
+
+  if (fc_font) {
+    FcPatternDestroy(fc_font);
+  }
+
+  std::vector<std::string> stamps;
+  font_read_config_stamps(fc_config, &stamps);
 
-  if (font_file.empty()) {
+  FcPatternDestroy(fc_pattern);
+  FcConfigDestroy(fc_config);
+
+  if (!found) {
     return errorf(ERROR, "unable to find font: ${}", font_pattern);
   }
 
+  font_cache_store(cache_key, {*font}, stamps);
+  return OK;
+}
+
+ReturnCode font_load_best(
+    const std::string& font_pattern,
+    FontInfo* font_info) {
+  if (font_pattern.empty()) {
+    return error(ERROR, "unable to load font: empty font pattern");
+  }
+
+  {
+    auto registry = font_registry();
+    std::lock_guard<std::mutex> lk(registry->lock);
+    if (registry->load_disabled) {
+      return errorf(
+          ERROR,
+          "unable to load font '{}': loading fonts is disabled; the fonts "
+          "must be loaded on startup (--font-load)",
+          font_pattern);
+    }
+  }
+
   FontRef font_ref;
-  if (auto rc = font_load(font_file, &font_ref); !rc) {
-    return errorf(
-        ERROR,
-        "unble to load font '{}': {}",
-        font_file,
-        rc.message);
+  if (font_pattern[0] == '/' ||
+      StringUtil::endsWith(font_pattern, ".otf") ||
+      StringUtil::endsWith(font_pattern, ".ttf")) { // TODO improved filename detection
+    if (auto rc = font_load(font_pattern, &font_ref); !rc) {
+      return errorf(
+          ERROR,
+          "unble to load font '{}': {}",
+          font_pattern,
+          rc.message);
+    }
+  } else {
+    FontCacheEntry font;
+    if (auto rc = font_find_best(font_pattern, &font); !rc) {
+      return rc;
+    }
+
+    // open the face on the calling thread to make sure that the font is usable
+    font_ref = font_register(font);
+    if (!font_get_freetype(font_ref)) {
+      return errorf(
+          ERROR,
+          "unble to load font '{}': unable to open font face",
+          font.file);
+    }
   }
 
-  font_info->fonts.insert(font_info->fonts.begin(), font_ref);
-  font_info->font_family_css.clear();
+  auto stack = *font_info->stack;
+  stack.fonts.insert(stack.fonts.begin(), font_ref);
+  stack.font_family_css.clear();
+
+  font_info->stack = font_stack_intern(stack);
   return OK;
 }
 
-ReturnCode font_load_defaults(FontInfo* font_info) {
-  std::vector<std::string> font_files;
+void font_load_disable() {
+  auto registry = font_registry();
+  std::lock_guard<std::mutex> lk(registry->lock);
+  registry->load_disabled = true;
+}
+
+ReturnCode font_find_defaults(std::vector<FontCacheEntry>* fonts) {
+  auto cache_key = std::string("sort:") + DEFAULT_FONT_PATTERN_FC;
+  if (font_cache_lookup(cache_key, fonts)) {
+    return OK;
+  }
 
   auto fc_config = FcInitLoadConfigAndFonts();
-  auto fc_objs = FcObjectSetBuild(FC_FILE, nullptr);
   auto fc_pattern = FcNameParse((FcChar8*) DEFAULT_FONT_PATTERN_FC);
 
   FcDefaultSubstitute(fc_pattern);
   FcConfigSubstitute(fc_config, fc_pattern, FcMatchPattern);
 
   FcResult fc_res;
-  FcFontSet* fc_fontset = FcFontSort(0, fc_pattern, FcTrue, 0, &fc_res);
+  FcFontSet* fc_fontset = FcFontSort(fc_config, fc_pattern, FcTrue, 0, &fc_res);
 
   if (fc_fontset) {
     for (size_t i=0; i < fc_fontset->nfont; ++i) {
-      char* fc_file = nullptr;
-      auto fc_file_rc = FcPatternGetString(
-          fc_fontset->fonts[i],
-          FC_FILE,
-          0,
-          reinterpret_cast<FcChar8**>(&fc_file));
-
-      if (fc_file_rc != FcResultMatch) {
-        continue;
+      FontCacheEntry font;
+      if (font_read_pattern(fc_fontset->fonts[i], &font)) {
+        fonts->emplace_back(std::move(font));
       }
-
-      font_files.emplace_back(fc_file);
     }
 
     FcFontSetDestroy(fc_fontset);
   }
 
+  std::vector<std::string> stamps;
+  font_read_config_stamps(fc_config, &stamps);
+
   FcPatternDestroy(fc_pattern);
   FcConfigDestroy(fc_config);
 
-  for (const auto& font_file : font_files) {
-    FontRef font_ref;
-    if (auto rc = font_load(font_file, &font_ref); !rc) {
-      return errorf(
-          ERROR,
-          "unble to load font '{}': {}",
-          font_file,
-          rc.message);
+  font_cache_store(cache_key, *fonts, stamps);
+  return OK;
+}
+
+ReturnCode font_load_defaults(FontInfo* font_info) {
+  auto registry = font_registry();
+
+  // the default fonts are only looked up once per process and then shared
+  // by all contexts. the font files are not opened here; each face is only
+  // opened once the font fallback actually needs it
+  std::unique_lock<std::mutex> lk(registry->lock);
+  if (!registry->defaults_loaded) {
+    lk.unlock();
+
+    std::vector<FontCacheEntry> font_candidates;
+    if (auto rc = font_find_defaults(&font_candidates); !rc) {
+      return rc;
     }
 
-    font_info->fonts.push_back(font_ref);
+    std::vector<FontRef> fonts;
+    for (const auto& font : font_candidates) {
+      fonts.push_back(font_register(font));
+    }
+
+    lk.lock();
+    if (!registry->defaults_loaded) {
+      registry->defaults = std::move(fonts);
+      registry->defaults_loaded = true;
+    }
+  }
+
+  auto stack = *font_info->stack;
+  stack.fonts.insert(
+      stack.fonts.end(),
+      registry->defaults.begin(),
+      registry->defaults.end());
+
+  lk.unlock();
+
+  stack.font_family_css = DEFAULT_FONT_PATTERN_CSS;
+  stack.font_weight_css = 500;
+
+  font_info->stack = font_stack_intern(stack);
+  return OK;
+}
+
+ReturnCode font_subset(
+    const FontRef& font,
+    const std::set<uint32_t>& codepoints,
+    std::string* data) {
+  FontFileMappingRef file;
+  if (auto rc = font_map_file(font->file, &file); !rc) {
+    return rc;
+  }
+
+  // the blob references the shared file mapping, which is never released
+  auto blob = hb_blob_create(
+      static_cast<const char*>(file->data),
+      file->size,
+      HB_MEMORY_MODE_READONLY,
+      nullptr,
+      nullptr);
+
+  auto face = hb_face_create(blob, font->face_index);
+  hb_blob_destroy(blob);
+
+  auto input = hb_subset_input_create_or_fail();
+  if (!input) {
+    hb_face_destroy(face);
+    return error(ERROR, "unable to create the font subset input");
+  }
+
+  auto input_codepoints = hb_subset_input_unicode_set(input);
+  for (const auto& codepoint : codepoints) {
+    hb_set_add(input_codepoints, codepoint);
+  }
+
+  auto face_subset = hb_subset_or_fail(face, input);
+  hb_subset_input_destroy(input);
+  hb_face_destroy(face);
+
+  if (!face_subset) {
+    return errorf(ERROR, "unable to subset font file '{}'", font->file);
+  }
+
+  auto blob_subset = hb_face_reference_blob(face_subset);
+  unsigned int blob_subset_len = 0;
+  auto blob_subset_data = hb_blob_get_data(blob_subset, &blob_subset_len);
+  data->assign(blob_subset_data, blob_subset_len);
+  hb_blob_destroy(blob_subset);
+  hb_face_destroy(face_subset);
+
+  if (data->empty()) {
+    return errorf(ERROR, "unable to subset font file '{}'", font->file);
   }
 
-  font_info->font_family_css = DEFAULT_FONT_PATTERN_CSS;
-  font_info->font_weight_css = 500;
   return OK;
 }
 
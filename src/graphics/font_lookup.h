@@ -13,6 +13,8 @@
  */
 #pragma once
 #include <memory>
+#include <set>
+#include <string>
 #include "return_code.h"
 #include "path.h"
 
@@ -21,12 +23,34 @@ namespace clip {
 struct FontStorage;
 using FontRef = std::shared_ptr<FontStorage>;
 
-struct FontInfo {
+/**
+ * A font stack is the list of fonts that are tried in order when rendering
+ * text. Font stacks are interned and never freed, so they can be referenced
+ * using a plain pointer. Fonts and the mappings of their files are never freed
+ * either, so every distinct font or font combination that is loaded adds to the
+ * memory use of the process until it exits.
+ */
+struct FontStack {
   std::vector<FontRef> fonts;
   std::string font_family_css;
   double font_weight_css;
 };
 
+/**
+ * A font info is a handle to an interned font stack. It is cheap to copy and
+ * refers to the empty font stack by default.
+ */
+struct FontInfo {
+  FontInfo();
+  const FontStack* stack;
+};
+
+/**
+ * Return the interned copy of the given font stack. Equal font stacks are only
+ * stored once.
+ */
+const FontStack* font_stack_intern(const FontStack& stack);
+
 ReturnCode font_load(
     const std::string& font_file,
     FontRef* font);
@@ -37,6 +61,13 @@ ReturnCode font_load_best(
     const std::string& font_pattern,
     FontInfo* font_info);
 
+/**
+ * Reject all further calls to font_load_best. Long-running processes that
+ * evaluate input from untrusted clients load their fonts on startup and then
+ * disable font loading, so that the clients can not grow the font registry.
+ */
+void font_load_disable();
+
 ReturnCode font_get_glyph_path(
     FontRef font,
     double font_size,
@@ -44,7 +75,48 @@ ReturnCode font_get_glyph_path(
     uint32_t codepoint,
     Path* path);
 
+/**
+ * Return the FreeType face of the font for the calling thread. Faces are
+ * opened once per thread and font. The returned face has its default size
+ * active; callers may resize it without affecting the cached sizes returned
+ * by font_get_freetype_sized.
+ */
 void* font_get_freetype(FontRef font);
 
+/**
+ * Return the FreeType face of the font with the given font size and
+ * resolution active. The size object is cached per thread, font and size.
+ * The returned face is only valid until the next call to one of the
+ * font_get_freetype functions on the same thread.
+ */
+void* font_get_freetype_sized(FontRef font, double font_size, double dpi);
+
+/**
+ * Open a new FreeType face for the font that is owned by the caller. The face
+ * is not shared with the font lookup, so the caller may change its size and
+ * transform, e.g. by handing it to cairo. The face must be released with
+ * font_close_freetype, which may be called from any thread.
+ */
+void* font_open_freetype(FontRef font);
+
+void font_close_freetype(void* face);
+
+/**
+ * Check if the font has a glyph for the given codepoint. Fonts that were found
+ * using fontconfig are checked against their coverage without opening the
+ * font file; all other fonts are checked using their character map.
+ */
+bool font_has_codepoint(const FontRef& font, uint32_t codepoint);
+
+/**
+ * Create a subset of the font that only contains the glyphs required to
+ * render the given codepoints. The subset is returned as an OpenType/TrueType
+ * font file in `data`.
+ */
+ReturnCode font_subset(
+    const FontRef& font,
+    const std::set<uint32_t>& codepoints,
+    std::string* data);
+
 } // namespace clip
 
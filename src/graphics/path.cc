@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #include <iostream>
+#include <math.h>
 #include "path.h"
 
 namespace clip {
@@ -155,6 +156,111 @@ Polygon2 path_to_polygon_simple(const Path& path) {
   return poly;
 }
 
+static const size_t kPathFlattenDepthMax = 16;
+
+double path_flatten_chord_distance(vec2 p, vec2 a, vec2 b) {
+  auto chord = sub(b, a);
+  auto chord_len = magnitude(chord);
+  if (chord_len == 0) {
+    return magnitude(sub(p, a));
+  }
+
+  return fabs(chord.x * (p.y - a.y) - chord.y * (p.x - a.x)) / chord_len;
+}
+
+void path_flatten_cubic(
+    vec2 p0,
+    vec2 c1,
+    vec2 c2,
+    vec2 p1,
+    double tolerance,
+    size_t depth,
+    std::vector<vec2>* vertices) {
+  auto flat =
+      path_flatten_chord_distance(c1, p0, p1) <= tolerance &&
+      path_flatten_chord_distance(c2, p0, p1) <= tolerance;
+
+  if (flat || depth >= kPathFlattenDepthMax) {
+    vertices->emplace_back(p1);
+    return;
+  }
+
+  // split the curve in half using de casteljau's algorithm
+  auto m01 = mul(add(p0, c1), 0.5);
+  auto m12 = mul(add(c1, c2), 0.5);
+  auto m23 = mul(add(c2, p1), 0.5);
+  auto m012 = mul(add(m01, m12), 0.5);
+  auto m123 = mul(add(m12, m23), 0.5);
+  auto m = mul(add(m012, m123), 0.5);
+
+  path_flatten_cubic(p0, m01, m012, m, tolerance, depth + 1, vertices);
+  path_flatten_cubic(m, m123, m23, p1, tolerance, depth + 1, vertices);
+}
+
+void path_flatten(
+    const Path& path,
+    double tolerance,
+    std::vector<PathPolyline>* polylines) {
+  PathPolyline* polyline = nullptr;
+  vec2 start;
+  vec2 cur;
+
+  for (const auto& cmd : path) {
+    // segments that do not follow a MOVE_TO start from the current point
+    if (!polyline && cmd.command != PathCommand::MOVE_TO) {
+      polylines->emplace_back(PathPolyline{{cur}, false});
+      polyline = &polylines->back();
+      start = cur;
+    }
+
+    switch (cmd.command) {
+      case PathCommand::MOVE_TO:
+        cur = vec2(cmd[0], cmd[1]);
+        start = cur;
+        polylines->emplace_back(PathPolyline{{cur}, false});
+        polyline = &polylines->back();
+        break;
+      case PathCommand::LINE_TO:
+        cur = vec2(cmd[0], cmd[1]);
+        polyline->vertices.emplace_back(cur);
+        break;
+      case PathCommand::QUADRATIC_CURVE_TO: {
+        // the quadratic curve is elevated to an equivalent cubic curve
+        vec2 c(cmd[0], cmd[1]);
+        vec2 p1(cmd[2], cmd[3]);
+        path_flatten_cubic(
+            cur,
+            add(cur, mul(sub(c, cur), 2.0 / 3.0)),
+            add(p1, mul(sub(c, p1), 2.0 / 3.0)),
+            p1,
+            tolerance,
+            0,
+            &polyline->vertices);
+        cur = p1;
+        break;
+      }
+      case PathCommand::CUBIC_CURVE_TO: {
+        vec2 p1(cmd[4], cmd[5]);
+        path_flatten_cubic(
+            cur,
+            vec2(cmd[0], cmd[1]),
+            vec2(cmd[2], cmd[3]),
+            p1,
+            tolerance,
+            0,
+            &polyline->vertices);
+        cur = p1;
+        break;
+      }
+      case PathCommand::CLOSE:
+        polyline->closed = true;
+        polyline = nullptr;
+        cur = start;
+        break;
+    }
+  }
+}
+
 Path path_from_polygon(const Polygon2& poly) {
   Path p;
 
@@ -67,12 +67,31 @@ protected:
   std::vector<PathData> data_;
 };
 
+/**
+ * A list of vertices connected by straight lines. If the polyline is closed,
+ * the last vertex is also connected to the first vertex.
+ */
+struct PathPolyline {
+  std::vector<vec2> vertices;
+  bool closed;
+};
+
 /**
  * Convert a simple path that consists only of straight line segments and is free
  * of self-intersections to a polygon
  */
 Polygon2 path_to_polygon_simple(const Path& path);
 
+/**
+ * Flatten a path into one polyline per subpath. Curves are subdivided until
+ * their control points are less than `tolerance` away from the chord of the
+ * curve.
+ */
+void path_flatten(
+    const Path& path,
+    double tolerance,
+    std::vector<PathPolyline>* polylines);
+
 /**
  * Convert a polygon to a path
  */
@@ -85,5 +85,126 @@ Status pngWriteImageFile(
   return OK;
 }
 
+struct PNGWriter {
+  const std::function<ReturnCode (const char* data, size_t size)>* write;
+  ReturnCode rc;
+};
+
+void png_write_cb(png_structp png, png_bytep data, png_size_t size) {
+  auto writer = static_cast<PNGWriter*>(png_get_io_ptr(png));
+
+  // once the writer failed, the remaining output is discarded
+  if (writer->rc) {
+    writer->rc = (*writer->write)((const char*) data, size);
+  }
+}
+
+void png_flush_cb(png_structp) {}
+
+/**
+ * Encode the image with libpng. All state that is modified while encoding is
+ * owned by the caller and set up before setjmp, so nothing here is read after
+ * libpng reports an error through longjmp.
+ */
+bool png_write_argb32_rows(
+    png_structp png,
+    png_infop png_info,
+    PNGWriter* writer,
+    png_byte* row,
+    const unsigned char* data,
+    uint32_t width,
+    uint32_t height,
+    size_t stride) {
+  if (setjmp(png_jmpbuf(png))) {
+    return false;
+  }
+
+  png_set_write_fn(png, writer, &png_write_cb, &png_flush_cb);
+
+  png_set_IHDR(
+      png,
+      png_info,
+      width,
+      height,
+      8,
+      PNG_COLOR_TYPE_RGB_ALPHA,
+      PNG_INTERLACE_NONE,
+      PNG_COMPRESSION_TYPE_BASE,
+      PNG_FILTER_TYPE_BASE);
+
+  png_write_info(png, png_info);
+
+  for (size_t y = 0; y < height && writer->rc; ++y) {
+    auto src = reinterpret_cast<const uint32_t*>(data + y * stride);
+
+    for (size_t x = 0; x < width; ++x) {
+      uint32_t a = src[x] >> 24;
+      uint32_t r = (src[x] >> 16) & 0xff;
+      uint32_t g = (src[x] >> 8) & 0xff;
+      uint32_t b = src[x] & 0xff;
+
+      if (a > 0 && a < 0xff) {
+        r = (r * 0xff + a / 2) / a;
+        g = (g * 0xff + a / 2) / a;
+        b = (b * 0xff + a / 2) / a;
+      }
+
+      row[x * 4 + 0] = r;
+      row[x * 4 + 1] = g;
+      row[x * 4 + 2] = b;
+      row[x * 4 + 3] = a;
+    }
+
+    png_write_row(png, row);
+  }
+
+  if (writer->rc) {
+    png_write_end(png, png_info);
+  }
+
+  return true;
+}
+
+ReturnCode png_write_argb32(
+    const unsigned char* data,
+    uint32_t width,
+    uint32_t height,
+    size_t stride,
+    const std::function<ReturnCode (const char* data, size_t size)>& write) {
+  PNGWriter writer;
+  writer.write = &write;
+
+  auto png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (!png) {
+    return error(ERROR, "unable to create the PNG writer");
+  }
+
+  auto png_info = png_create_info_struct(png);
+  if (!png_info) {
+    png_destroy_write_struct(&png, NULL);
+    return error(ERROR, "unable to create the PNG writer");
+  }
+
+  std::vector<png_byte> row(size_t(width) * 4);
+
+  auto encoded = png_write_argb32_rows(
+      png,
+      png_info,
+      &writer,
+      row.data(),
+      data,
+      width,
+      height,
+      stride);
+
+  png_destroy_write_struct(&png, &png_info);
+
+  if (!encoded) {
+    return error(ERROR, "unable to encode the PNG image");
+  }
+
+  return writer.rc;
+}
+
 } // namespace clip
 
@@ -13,6 +13,7 @@
  */
 #pragma once
 #include <stdlib.h>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -25,5 +26,18 @@ Status pngWriteImageFile(
     const Image& image,
     const std::string& filename);
 
+/**
+ * Encode an image with premultiplied 32-bit ARGB pixels in native byte order,
+ * as used by cairo image surfaces, as a PNG file. The rows are converted and
+ * compressed one by one and the output is handed to the write function as it
+ * is produced, so the encoded image is never held in memory at once.
+ */
+ReturnCode png_write_argb32(
+    const unsigned char* data,
+    uint32_t width,
+    uint32_t height,
+    size_t stride,
+    const std::function<ReturnCode (const char* data, size_t size)>& write);
+
 } // namespace clip
 
@@ -17,9 +17,18 @@
 #include "graphics/shape_hatch.h"
 
 #include <iostream>
+#include <math.h>
+#include <string.h>
+#include FT_OUTLINE_H
 
 namespace clip {
 
+/**
+ * Glyphs in the glyph atlas are rendered at a quarter pixel horizontal offset
+ * resolution
+ */
+static const uint32_t kGlyphSubpixelSteps = 4;
+
 Rasterizer::Rasterizer(
     uint32_t width_,
     uint32_t height_,
@@ -36,37 +45,137 @@ Rasterizer::Rasterizer(
 }
 
 Rasterizer::~Rasterizer() {
+  for (const auto& g : glyph_atlas) {
+    if (g.second.mask) {
+      cairo_surface_destroy(g.second.mask);
+    }
+  }
+
+  for (const auto& f : font_faces) {
+    cairo_font_face_destroy(f.second);
+  }
+
   cairo_destroy(cr_ctx);
   cairo_surface_destroy(cr_surface);
 }
 
-void cairo_set_path(
-    cairo_t* cr_ctx,
-    uint32_t height,
-    const Path& path) {
-  cairo_new_path(cr_ctx);
-
-  for (const auto& cmd : path) {
-    switch (cmd.command) {
-      case PathCommand::MOVE_TO:
-        cairo_move_to(cr_ctx, cmd[0], height - cmd[1]);
-        break;
-      case PathCommand::LINE_TO:
-        cairo_line_to(cr_ctx, cmd[0], height - cmd[1]);
-        break;
-      case PathCommand::CLOSE:
-        cairo_close_path(cr_ctx);
-        break;
+static const cairo_user_data_key_t kFontFaceKey = {};
+
+void rasterizer_font_face_destroy(void* ft_font) {
+  font_close_freetype(ft_font);
+}
+
+cairo_font_face_t* Rasterizer::getFontFace(const FontRef& font) {
+  auto& cairo_face = font_faces[font.get()];
+  if (!cairo_face) {
+    // cairo sets the transform and character size on the face when it renders
+    // glyphs, so it gets its own face instead of the per-thread face that is
+    // used for shaping and the glyph atlas. the face may outlive the
+    // rasterizer in the cairo font cache, so it is released by cairo
+    auto ft_font = static_cast<FT_Face>(font_open_freetype(font));
+    if (!ft_font) {
+      font_faces.erase(font.get());
+      return nullptr;
+    }
+
+    cairo_face = cairo_ft_font_face_create_for_ft_face(ft_font, 0);
+
+    auto rc = cairo_font_face_set_user_data(
+        cairo_face,
+        &kFontFaceKey,
+        ft_font,
+        &rasterizer_font_face_destroy);
+
+    if (rc != CAIRO_STATUS_SUCCESS) {
+      cairo_font_face_destroy(cairo_face);
+      font_close_freetype(ft_font);
+      font_faces.erase(font.get());
+      return nullptr;
     }
   }
+
+  return cairo_face;
+}
+
+const RasterizerGlyph& Rasterizer::getGlyph(
+    const FontRef& font,
+    double font_size,
+    uint32_t codepoint,
+    uint32_t subpixel_offset) {
+  auto key = std::make_tuple(font.get(), font_size, codepoint, subpixel_offset);
+  auto glyph_iter = glyph_atlas.find(key);
+  if (glyph_iter != glyph_atlas.end()) {
+    return glyph_iter->second;
+  }
+
+  auto& glyph = glyph_atlas[key];
+  glyph.rendered = false;
+  glyph.mask = nullptr;
+
+  auto ft_font = static_cast<FT_Face>(
+      font_get_freetype_sized(font, font_size, dpi));
+
+  if (!ft_font ||
+      FT_Load_Glyph(ft_font, codepoint, FT_LOAD_DEFAULT) ||
+      ft_font->glyph->format != FT_GLYPH_FORMAT_OUTLINE) {
+    return glyph;
+  }
+
+  FT_Outline_Translate(
+      &ft_font->glyph->outline,
+      (64 * subpixel_offset) / kGlyphSubpixelSteps,
+      0);
+
+  if (FT_Render_Glyph(ft_font->glyph, FT_RENDER_MODE_NORMAL)) {
+    return glyph;
+  }
+
+  const auto& bitmap = ft_font->glyph->bitmap;
+  if (bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+    return glyph;
+  }
+
+  glyph.rendered = true;
+  glyph.left = ft_font->glyph->bitmap_left;
+  glyph.top = ft_font->glyph->bitmap_top;
+
+  // empty glyphs, e.g. spaces, have no mask
+  if (bitmap.width == 0 || bitmap.rows == 0) {
+    return glyph;
+  }
+
+  glyph.mask = cairo_image_surface_create(
+      CAIRO_FORMAT_A8,
+      bitmap.width,
+      bitmap.rows);
+
+  cairo_surface_flush(glyph.mask);
+  auto mask_data = cairo_image_surface_get_data(glyph.mask);
+  auto mask_stride = cairo_image_surface_get_stride(glyph.mask);
+  for (size_t y = 0; y < bitmap.rows; ++y) {
+    memcpy(
+        mask_data + y * mask_stride,
+        bitmap.buffer + y * bitmap.pitch,
+        bitmap.width);
+  }
+
+  cairo_surface_mark_dirty(glyph.mask);
+  return glyph;
 }
 
-Status Rasterizer::drawShape(
+/**
+ * Shapes are drawn by the scanline rasterizer directly into the pixel buffer
+ * of the cairo surface; cairo is only used for text
+ */
+ReturnCode Rasterizer::drawShape(
     const Path& path,
     const StrokeStyle& stroke_style,
-    const FillStyle& fill_style) {
+    const FillStyle& fill_style,
+    const std::optional<AntialiasingMode>& antialiasing_mode) {
+  // a path without any segments, e.g. a line with a single point, does not
+  // cover any pixels
   if (path.size() < 2) {
-    return ERROR;
+    return OK;
   }
 
   auto fill_path = path;
@@ -79,55 +188,43 @@ Status Rasterizer::drawShape(
         fill_style.hatch_width);
   }
 
-  if (fill_style.color) {
-    cairo_set_source_rgba(
-       cr_ctx,
-       fill_style.color->red(),
-       fill_style.color->green(),
-       fill_style.color->blue(),
-       fill_style.color->alpha());
-
-    cairo_set_path(cr_ctx, height, fill_path);
-    cairo_fill(cr_ctx);
-  }
-
-  if (stroke_style.line_width) {
-    switch (stroke_style.dash_type) {
-      case StrokeStyle::SOLID:
-        cairo_set_dash(cr_ctx, nullptr, 0, 0);
-        break;
-      case StrokeStyle::DASH: {
-        std::vector<double> dash_pattern;
-        for (const auto& v : stroke_style.dash_pattern) {
-          dash_pattern.push_back(v);
-        }
+  // paths use a bottom-left origin while the pixel buffer starts at the top
+  auto proj = mul(translate2({0, double(height)}), scale2({1, -1}));
 
-        cairo_set_dash(
-            cr_ctx,
-            dash_pattern.data(),
-            dash_pattern.size(),
-            stroke_style.dash_offset);
-        break;
-      }
-    }
+  ScanlineTarget target;
+  target.data = cairo_image_surface_get_data(cr_surface);
+  target.width = width;
+  target.height = height;
+  target.stride = stride();
+  target.format = ScanlinePixelFormat::ARGB32_PREMULTIPLIED;
 
-    cairo_set_source_rgba(
-       cr_ctx,
-       stroke_style.color.red(),
-       stroke_style.color.green(),
-       stroke_style.color.blue(),
-       stroke_style.color.alpha());
+  cairo_surface_flush(cr_surface);
 
-    cairo_set_line_width(cr_ctx, stroke_style.line_width);
-    cairo_set_path(cr_ctx, height, path);
-    cairo_stroke(cr_ctx);
+  ReturnCode rc;
+  if (fill_style.color) {
+    rc = scanline_fill_path(
+        &scanline,
+        target,
+        path_transform(fill_path, proj),
+        *fill_style.color,
+        antialiasing_mode);
   }
 
-  return OK;
+  if (rc && stroke_style.line_width) {
+    rc = scanline_stroke_path(
+        &scanline,
+        target,
+        path_transform(path, proj),
+        stroke_style,
+        antialiasing_mode);
+  }
+
+  cairo_surface_mark_dirty(cr_surface);
+  return rc;
 }
 
-Status Rasterizer::drawText(
-    const std::vector<text::GlyphPlacementGroup>& glyphs,
+ReturnCode Rasterizer::drawText(
+    const text::GlyphPlacementList& glyphs,
     const TextStyle& style,
     const std::optional<mat3>& transform) {
   if (transform) {
@@ -147,14 +244,8 @@ Status Rasterizer::drawText(
     cairo_identity_matrix(cr_ctx);
   }
 
-  for (const auto& gg : glyphs) {
-
-    auto ft_font = static_cast<FT_Face>(font_get_freetype(gg.font));
-    auto font_size_ft = style.font_size * (72.0 / dpi) * 64;
-    if (FT_Set_Char_Size(ft_font, 0, font_size_ft, dpi, dpi)) {
-      FT_Done_Face(ft_font);
-      return ERROR;
-    }
+  for (const auto& run : glyphs.runs) {
+    const auto& font = style.font.stack->fonts[run.font];
 
     cairo_set_source_rgba(
        cr_ctx,
@@ -163,23 +254,63 @@ Status Rasterizer::drawText(
        style.color.blue(),
        style.color.alpha());
 
-    auto cairo_face = cairo_ft_font_face_create_for_ft_face(ft_font, 0);
-    cairo_set_font_face(cr_ctx, cairo_face);
-    cairo_set_font_size(cr_ctx, style.font_size);
+    // untransformed glyphs are blitted from the glyph atlas. glyphs that are
+    // transformed or that can not be rendered into a mask (e.g. bitmap
+    // glyphs) are drawn by cairo
+    std::vector<cairo_glyph_t> cairo_glyphs;
+    for (auto i = run.glyph_begin; i < run.glyph_end; ++i) {
+      const auto& g = glyphs.glyphs[i];
+      auto gx = g.x;
+      auto gy = height - g.y;
+
+      if (!transform) {
+        auto gx_px = floor(gx);
+        auto subpixel_offset = uint32_t(
+            round((gx - gx_px) * kGlyphSubpixelSteps));
+
+        if (subpixel_offset == kGlyphSubpixelSteps) {
+          gx_px += 1;
+          subpixel_offset = 0;
+        }
+
+        const auto& ga = getGlyph(
+            font,
+            style.font_size,
+            g.codepoint,
+            subpixel_offset);
+
+        if (ga.rendered) {
+          if (ga.mask) {
+            cairo_mask_surface(
+                cr_ctx,
+                ga.mask,
+                gx_px + ga.left,
+                round(gy) - ga.top);
+          }
+
+          continue;
+        }
+      }
+
+      cairo_glyph_t cg;
+      cg.index = g.codepoint;
+      cg.x = gx;
+      cg.y = gy;
+      cairo_glyphs.push_back(cg);
+    }
 
-    auto glyph_count = gg.glyphs.size();
-    auto cairo_glyphs = cairo_glyph_allocate(glyph_count);
-    for (int i = 0; i < glyph_count; ++i) {
-      const auto& g = gg.glyphs[i];
+    if (cairo_glyphs.empty()) {
+      continue;
+    }
 
-      cairo_glyphs[i].index = g.codepoint;
-      cairo_glyphs[i].x = g.x;
-      cairo_glyphs[i].y = height - g.y;
+    auto cairo_face = getFontFace(font);
+    if (!cairo_face) {
+      return error(ERROR, "unable to create the cairo font face for a font");
     }
 
-    cairo_show_glyphs(cr_ctx, cairo_glyphs, glyph_count);
-    cairo_glyph_free(cairo_glyphs);
-    cairo_font_face_destroy(cairo_face);
+    cairo_set_font_face(cr_ctx, cairo_face);
+    cairo_set_font_size(cr_ctx, style.font_size);
+    cairo_show_glyphs(cr_ctx, cairo_glyphs.data(), cairo_glyphs.size());
   }
 
   return OK;
@@ -197,25 +328,16 @@ void Rasterizer::clear(const Color& c) {
 }
 
 const unsigned char* Rasterizer::data() const {
+  cairo_surface_flush(cr_surface);
   return cairo_image_surface_get_data(cr_surface);
 }
 
 size_t Rasterizer::size() const {
-  return width * height * 4;
-}
-
-cairo_status_t cr_copy(
-    void* closure,
-    const unsigned char* data,
-    unsigned int length) {
-  *static_cast<std::string*>(closure) += std::string((const char*) data, length);
-  return CAIRO_STATUS_SUCCESS;
+  return stride() * height;
 }
 
-std::string Rasterizer::to_png() const {
-  std::string buf;
-  cairo_surface_write_to_png_stream(cr_surface, cr_copy, &buf);
-  return buf;
+size_t Rasterizer::stride() const {
+  return cairo_image_surface_get_stride(cr_surface);
 }
 
 Status Rasterizer::writeToFile(const std::string& path) {
@@ -12,7 +12,9 @@
  * limitations under the License.
  */
 #pragma once
+#include <map>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <functional>
 
@@ -28,11 +30,25 @@
 #include "brush.h"
 #include "layout.h"
 #include "graphics/draw.h"
+#include "graphics/scanline.h"
 #include "text_layout.h"
 
 namespace clip {
 class Image;
 
+/**
+ * A rendered glyph coverage mask. The mask is placed so that its top left
+ * corner is at (left, -top) relative to the glyph origin. Empty glyphs are
+ * rendered without a mask; glyphs that can not be rendered into a mask are
+ * not rendered at all.
+ */
+struct RasterizerGlyph {
+  bool rendered;
+  cairo_surface_t* mask;
+  int left;
+  int top;
+};
+
 class Rasterizer {
 public:
 
@@ -43,20 +59,33 @@ public:
 
   void clear(const Color& c);
 
-  Status drawShape(
+  ReturnCode drawShape(
       const Path& path,
       const StrokeStyle& stroke_style,
-      const FillStyle& fill_style);
+      const FillStyle& fill_style,
+      const std::optional<AntialiasingMode>& antialiasing_mode = std::nullopt);
 
-  Status drawText(
-      const std::vector<text::GlyphPlacementGroup>& glyphs,
+  ReturnCode drawText(
+      const text::GlyphPlacementList& glyphs,
       const TextStyle& style,
       const std::optional<mat3>& transform);
 
   Status writeToFile(const std::string& path);
 
-  std::string to_png() const;
+  cairo_font_face_t* getFontFace(const FontRef& font);
+
+  const RasterizerGlyph& getGlyph(
+      const FontRef& font,
+      double font_size,
+      uint32_t codepoint,
+      uint32_t subpixel_offset);
+
+  /**
+   * The pixel data is stored as premultiplied 32-bit ARGB values in native
+   * byte order, with `stride` bytes per row
+   */
   const unsigned char* data() const;
+  size_t stride() const;
   size_t size() const;
 
   uint32_t width;
@@ -64,6 +93,18 @@ public:
   double dpi;
   cairo_surface_t* cr_surface;
   cairo_t* cr_ctx;
+
+  /**
+   * The cairo font faces and glyph masks are cached for the lifetime of the
+   * rasterizer so that repeated labels are blitted from the glyph atlas
+   * instead of being rasterized again.
+   */
+  std::unordered_map<const void*, cairo_font_face_t*> font_faces;
+  std::map<
+      std::tuple<const void*, double, uint32_t, uint32_t>,
+      RasterizerGlyph> glyph_atlas;
+
+  ScanlineRasterizer scanline;
 };
 
 using RasterizerRef = std::shared_ptr<Rasterizer>;
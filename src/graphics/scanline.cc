@@ -0,0 +1,667 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "graphics/scanline.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace clip {
+
+/**
+ * Curves are flattened so that they deviate less than a tenth of a pixel from
+ * the exact curve
+ */
+static const double kScanlineFlattenTolerance = 0.1;
+
+/**
+ * Miter joins are replaced by bevel joins if the miter is longer than ten
+ * times the line width (the same limit that cairo uses by default)
+ */
+static const double kScanlineMiterLimit = 10.0;
+
+/**
+ * A color with unpremultiplied channels in the range 0..255 and an alpha
+ * value in the range 0..1
+ */
+struct ScanlineColor {
+  float r;
+  float g;
+  float b;
+  float a;
+};
+
+ScanlineRasterizer::ScanlineRasterizer() :
+    width(0),
+    height(0),
+    x_min(0),
+    x_max(0),
+    y_min(0),
+    y_max(0) {}
+
+/**
+ * Each row in the area buffer has two additional columns so that edges on the
+ * right border of the target can be accumulated without bounds checks
+ */
+void scanline_init(
+    ScanlineRasterizer* r,
+    uint32_t width,
+    uint32_t height) {
+  if (r->width == width && r->height == height) {
+    return;
+  }
+
+  r->width = width;
+  r->height = height;
+  r->area.assign(size_t(width + 2) * height, 0.0f);
+  r->coverage.assign(width + 2, 0.0f);
+  r->x_min = width + 2;
+  r->x_max = 0;
+  r->y_min = height;
+  r->y_max = 0;
+}
+
+ReturnCode scanline_target_image(Image* image, ScanlineTarget* target) {
+  if (image->getPixelFormat() != PixelFormat::RGBA8) {
+    return error(ERROR, "the scanline rasterizer only supports RGBA8 images");
+  }
+
+  target->data = static_cast<unsigned char*>(image->getData());
+  target->width = image->getWidth();
+  target->height = image->getHeight();
+  target->stride = image->getWidth() * image->getPixelSize();
+  target->format = ScanlinePixelFormat::RGBA8;
+  return OK;
+}
+
+/**
+ * Accumulate the signed area of a line segment that lies fully inside the
+ * rows of the buffer and inside the columns 0..width. The segment is given
+ * from top to bottom and `dir` is the sign of its original direction.
+ */
+void scanline_accumulate_line(
+    ScanlineRasterizer* r,
+    vec2 p0,
+    vec2 p1,
+    double dir) {
+  auto row_len = r->width + 2;
+  auto dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+  auto x = p0.x;
+
+  auto y_begin = uint32_t(p0.y);
+  auto y_end = std::min(uint32_t(ceil(p1.y)), r->height);
+  for (auto y = y_begin; y < y_end; ++y) {
+    auto row = r->area.data() + size_t(y) * row_len;
+    auto dy = std::min(double(y + 1), p1.y) - std::max(double(y), p0.y);
+    auto x_next = std::clamp(x + dxdy * dy, 0.0, double(r->width));
+    auto d = dy * dir;
+
+    auto x0 = std::min(x, x_next);
+    auto x1 = std::max(x, x_next);
+    auto x0_floor = floor(x0);
+    auto x0_i = uint32_t(x0_floor);
+    auto x1_ceil = ceil(x1);
+    auto x1_i = uint32_t(x1_ceil);
+
+    if (x1_i <= x0_i + 1) {
+      // the segment stays within one pixel in this row
+      auto xm = 0.5 * (x + x_next) - x0_floor;
+      row[x0_i] += d - d * xm;
+      row[x0_i + 1] += d * xm;
+    } else {
+      // the segment crosses multiple pixels in this row; the area is split
+      // into a triangle in the first pixel, a triangle in the last pixel and
+      // trapezoids in all pixels in between
+      auto s = 1.0 / (x1 - x0);
+      auto x0_f = x0 - x0_floor;
+      auto a0 = 0.5 * s * (1.0 - x0_f) * (1.0 - x0_f);
+      auto x1_f = x1 - x1_ceil + 1.0;
+      auto am = 0.5 * s * x1_f * x1_f;
+
+      row[x0_i] += d * a0;
+
+      if (x1_i == x0_i + 2) {
+        row[x0_i + 1] += d * (1.0 - a0 - am);
+      } else {
+        auto a1 = s * (1.5 - x0_f);
+        row[x0_i + 1] += d * (a1 - a0);
+
+        for (auto xi = x0_i + 2; xi < x1_i - 1; ++xi) {
+          row[xi] += d * s;
+        }
+
+        auto a2 = a1 + (x1_i - x0_i - 3) * s;
+        row[x1_i - 1] += d * (1.0 - a2 - am);
+      }
+
+      row[x1_i] += d * am;
+    }
+
+    x = x_next;
+  }
+
+  r->x_min = std::min(r->x_min, uint32_t(floor(std::min(p0.x, p1.x))));
+  r->x_max = std::max(r->x_max, uint32_t(ceil(std::max(p0.x, p1.x))) + 1);
+  r->y_min = std::min(r->y_min, y_begin);
+  r->y_max = std::max(r->y_max, y_end);
+}
+
+/**
+ * Add a line segment to the area buffer. Parts of the segment that are above
+ * or below the target are dropped since they do not cover any pixels. Parts
+ * that are left or right of the target are moved onto the border, which
+ * results in the same coverage inside the target.
+ */
+void scanline_add_line(ScanlineRasterizer* r, vec2 p0, vec2 p1) {
+  if (p0.y == p1.y || !std::isfinite(p0.x + p0.y + p1.x + p1.y)) {
+    return;
+  }
+
+  double dir = 1.0;
+  if (p0.y > p1.y) {
+    std::swap(p0, p1);
+    dir = -1.0;
+  }
+
+  double height = r->height;
+  if (p1.y <= 0 || p0.y >= height) {
+    return;
+  }
+
+  auto dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+  if (p0.y < 0) {
+    p0.x -= p0.y * dxdy;
+    p0.y = 0;
+  }
+
+  if (p1.y > height) {
+    p1.x -= (p1.y - height) * dxdy;
+    p1.y = height;
+  }
+
+  // split the segment where it crosses the left and right border
+  double width = r->width;
+  double splits[4] = { p0.y, p1.y, p1.y, p1.y };
+  size_t split_count = 1;
+  for (auto border : { 0.0, width }) {
+    if ((p0.x < border) != (p1.x < border) && p0.x != p1.x) {
+      auto y = p0.y + (border - p0.x) / dxdy;
+      if (y > p0.y && y < p1.y) {
+        splits[split_count++] = y;
+      }
+    }
+  }
+
+  splits[split_count] = p1.y;
+  std::sort(splits, splits + split_count + 1);
+
+  for (size_t i = 0; i < split_count; ++i) {
+    auto y0 = splits[i];
+    auto y1 = splits[i + 1];
+    if (y0 >= y1) {
+      continue;
+    }
+
+    auto x0 = std::clamp(p0.x + (y0 - p0.y) * dxdy, 0.0, width);
+    auto x1 = std::clamp(p0.x + (y1 - p0.y) * dxdy, 0.0, width);
+    scanline_accumulate_line(r, vec2(x0, y0), vec2(x1, y1), dir);
+  }
+}
+
+void scanline_add_polygon(
+    ScanlineRasterizer* r,
+    const vec2* vertices,
+    size_t vertex_count) {
+  for (size_t i = 0; i < vertex_count; ++i) {
+    scanline_add_line(r, vertices[i], vertices[(i + 1) % vertex_count]);
+  }
+}
+
+/**
+ * Add a polygon with a positive orientation so that the area of overlapping
+ * polygons is merged
+ */
+void scanline_add_polygon_oriented(
+    ScanlineRasterizer* r,
+    vec2* vertices,
+    size_t vertex_count) {
+  double area = 0;
+  for (size_t i = 0; i < vertex_count; ++i) {
+    const auto& a = vertices[i];
+    const auto& b = vertices[(i + 1) % vertex_count];
+    area += a.x * b.y - b.x * a.y;
+  }
+
+  if (area < 0) {
+    std::reverse(vertices, vertices + vertex_count);
+  }
+
+  scanline_add_polygon(r, vertices, vertex_count);
+}
+
+/**
+ * Integrate a row of the area buffer into coverage values in the range 0..1
+ * and clear the row for the next shape
+ */
+void scanline_accumulate_row(float* area, float* coverage, size_t len) {
+  size_t i = 0;
+  float sum = 0.0f;
+
+#if defined(__SSE2__)
+  auto offset = _mm_setzero_ps();
+  auto sign_mask = _mm_set1_ps(-0.0f);
+  auto one = _mm_set1_ps(1.0f);
+
+  for (; i + 4 <= len; i += 4) {
+    // compute the prefix sum of four values with two shifted additions
+    auto x = _mm_loadu_ps(area + i);
+    x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+    x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+    x = _mm_add_ps(x, offset);
+
+    _mm_storeu_ps(coverage + i, _mm_min_ps(_mm_andnot_ps(sign_mask, x), one));
+    _mm_storeu_ps(area + i, _mm_setzero_ps());
+
+    offset = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+
+  sum = _mm_cvtss_f32(offset);
+#endif
+
+  for (; i < len; ++i) {
+    sum += area[i];
+    coverage[i] = std::min(fabsf(sum), 1.0f);
+    area[i] = 0.0f;
+  }
+}
+
+void scanline_composite_argb32(
+    uint32_t* pixels,
+    const float* coverage,
+    size_t len,
+    const ScanlineColor& color) {
+  uint32_t solid =
+      (0xffu << 24) |
+      (uint32_t(color.r + 0.5f) << 16) |
+      (uint32_t(color.g + 0.5f) << 8) |
+      uint32_t(color.b + 0.5f);
+
+  for (size_t i = 0; i < len; ) {
+    // fully covered spans of an opaque color are filled without blending
+    if (coverage[i] >= 1.0f && color.a >= 1.0f) {
+      auto span_end = i + 1;
+      while (span_end < len && coverage[span_end] >= 1.0f) {
+        ++span_end;
+      }
+
+      std::fill(pixels + i, pixels + span_end, solid);
+      i = span_end;
+      continue;
+    }
+
+    auto a = color.a * coverage[i];
+    if (a <= 0.0f) {
+      ++i;
+      continue;
+    }
+
+    auto dst = pixels[i];
+    auto inv = 1.0f - a;
+    auto da = float(dst >> 24) * inv + 255.0f * a;
+    auto dr = float((dst >> 16) & 0xff) * inv + color.r * a;
+    auto dg = float((dst >> 8) & 0xff) * inv + color.g * a;
+    auto db = float(dst & 0xff) * inv + color.b * a;
+
+    pixels[i] =
+        (uint32_t(da + 0.5f) << 24) |
+        (uint32_t(dr + 0.5f) << 16) |
+        (uint32_t(dg + 0.5f) << 8) |
+        uint32_t(db + 0.5f);
+
+    ++i;
+  }
+}
+
+void scanline_composite_rgba8(
+    unsigned char* pixels,
+    const float* coverage,
+    size_t len,
+    const ScanlineColor& color) {
+  unsigned char solid_bytes[4] = {
+    (unsigned char) (color.r + 0.5f),
+    (unsigned char) (color.g + 0.5f),
+    (unsigned char) (color.b + 0.5f),
+    0xff
+  };
+
+  uint32_t solid;
+  memcpy(&solid, solid_bytes, sizeof(solid));
+
+  for (size_t i = 0; i < len; ) {
+    // fully covered spans of an opaque color are filled without blending
+    if (coverage[i] >= 1.0f && color.a >= 1.0f) {
+      auto span_end = i + 1;
+      while (span_end < len && coverage[span_end] >= 1.0f) {
+        ++span_end;
+      }
+
+      for (auto j = i; j < span_end; ++j) {
+        memcpy(pixels + j * 4, &solid, sizeof(solid));
+      }
+
+      i = span_end;
+      continue;
+    }
+
+    auto a = color.a * coverage[i];
+    if (a <= 0.0f) {
+      ++i;
+      continue;
+    }
+
+    auto dst = pixels + i * 4;
+    auto da = dst[3] / 255.0f * (1.0f - a);
+    auto oa = a + da;
+
+    dst[0] = (unsigned char) ((color.r * a + dst[0] * da) / oa + 0.5f);
+    dst[1] = (unsigned char) ((color.g * a + dst[1] * da) / oa + 0.5f);
+    dst[2] = (unsigned char) ((color.b * a + dst[2] * da) / oa + 0.5f);
+    dst[3] = (unsigned char) (oa * 255.0f + 0.5f);
+
+    ++i;
+  }
+}
+
+/**
+ * Composite the accumulated shape onto the target and clear the area buffer
+ */
+void scanline_flush(
+    ScanlineRasterizer* r,
+    const ScanlineTarget& target,
+    const Color& color,
+    const std::optional<AntialiasingMode>& antialiasing_mode) {
+  if (r->x_min >= r->x_max || r->y_min >= r->y_max) {
+    return;
+  }
+
+  ScanlineColor c;
+  c.r = std::clamp(color.red(), 0.0, 1.0) * 255.0f;
+  c.g = std::clamp(color.green(), 0.0, 1.0) * 255.0f;
+  c.b = std::clamp(color.blue(), 0.0, 1.0) * 255.0f;
+  c.a = std::clamp(color.alpha(), 0.0, 1.0);
+
+  auto aliased = antialiasing_mode == AntialiasingMode::DISABLE;
+  auto row_len = r->width + 2;
+  auto x_begin = r->x_min;
+  auto x_end = std::min(r->x_max + 1, row_len);
+  auto x_count = std::min(x_end, r->width) - x_begin;
+
+  for (auto y = r->y_min; y < r->y_max; ++y) {
+    auto area = r->area.data() + size_t(y) * row_len + x_begin;
+    auto coverage = r->coverage.data();
+    scanline_accumulate_row(area, coverage, x_end - x_begin);
+
+    if (aliased) {
+      for (size_t i = 0; i < x_count; ++i) {
+        coverage[i] = coverage[i] >= 0.5f ? 1.0f : 0.0f;
+      }
+    }
+
+    auto row = target.data + size_t(y) * target.stride;
+    switch (target.format) {
+      case ScanlinePixelFormat::ARGB32_PREMULTIPLIED:
+        scanline_composite_argb32(
+            reinterpret_cast<uint32_t*>(row) + x_begin,
+            coverage,
+            x_count,
+            c);
+        break;
+      case ScanlinePixelFormat::RGBA8:
+        scanline_composite_rgba8(row + x_begin * 4, coverage, x_count, c);
+        break;
+    }
+  }
+
+  r->x_min = row_len;
+  r->x_max = 0;
+  r->y_min = r->height;
+  r->y_max = 0;
+}
+
+ReturnCode scanline_fill_path(
+    ScanlineRasterizer* r,
+    const ScanlineTarget& target,
+    const Path& path,
+    const Color& color,
+    const std::optional<AntialiasingMode>& antialiasing_mode) {
+  scanline_init(r, target.width, target.height);
+
+  std::vector<PathPolyline> polylines;
+  path_flatten(path, kScanlineFlattenTolerance, &polylines);
+
+  // all subpaths are closed implicitly when filling
+  for (const auto& polyline : polylines) {
+    scanline_add_polygon(
+        r,
+        polyline.vertices.data(),
+        polyline.vertices.size());
+  }
+
+  scanline_flush(r, target, color, antialiasing_mode);
+  return OK;
+}
+
+/**
+ * Split a polyline into the dashes of a dash pattern. Odd length patterns are
+ * repeated twice so that dashes and gaps alternate, as in cairo.
+ */
+void scanline_dash_polyline(
+    const PathPolyline& polyline,
+    const StrokeStyle& style,
+    std::vector<PathPolyline>* dashes) {
+  std::vector<double> pattern;
+  for (const auto& v : style.dash_pattern) {
+    pattern.push_back(std::max(double(v), 0.0));
+  }
+
+  if (pattern.size() % 2) {
+    pattern.insert(pattern.end(), pattern.begin(), pattern.end());
+  }
+
+  double pattern_len = 0;
+  for (const auto& v : pattern) {
+    pattern_len += v;
+  }
+
+  if (pattern.empty() || pattern_len <= 0) {
+    dashes->emplace_back(polyline);
+    dashes->back().closed = false;
+    return;
+  }
+
+  auto offset = fmod(double(style.dash_offset), pattern_len);
+  if (offset < 0) {
+    offset += pattern_len;
+  }
+
+  size_t dash_idx = 0;
+  while (offset >= pattern[dash_idx]) {
+    offset -= pattern[dash_idx];
+    dash_idx = (dash_idx + 1) % pattern.size();
+  }
+
+  auto dash_remaining = pattern[dash_idx] - offset;
+  auto dash_on = dash_idx % 2 == 0;
+
+  auto vertices = polyline.vertices;
+  if (polyline.closed && !vertices.empty()) {
+    vertices.emplace_back(vertices.front());
+  }
+
+  if (dash_on && !vertices.empty()) {
+    dashes->emplace_back(PathPolyline{{vertices[0]}, false});
+  }
+
+  for (size_t i = 1; i < vertices.size(); ++i) {
+    auto from = vertices[i - 1];
+    auto to = vertices[i];
+    auto segment_len = magnitude(sub(to, from));
+    double segment_pos = 0;
+
+    while (segment_len - segment_pos > dash_remaining) {
+      segment_pos += dash_remaining;
+      auto p = add(from, mul(sub(to, from), segment_pos / segment_len));
+
+      if (dash_on) {
+        dashes->back().vertices.emplace_back(p);
+      } else {
+        dashes->emplace_back(PathPolyline{{p}, false});
+      }
+
+      dash_on = !dash_on;
+      dash_idx = (dash_idx + 1) % pattern.size();
+      dash_remaining = pattern[dash_idx];
+    }
+
+    dash_remaining -= segment_len - segment_pos;
+
+    if (dash_on) {
+      dashes->back().vertices.emplace_back(to);
+    }
+  }
+}
+
+/**
+ * Add the outline of a stroked polyline to the area buffer. Each segment is
+ * added as a rectangle and each join as a miter or bevel wedge on the outer
+ * side of the join.
+ */
+void scanline_stroke_polyline(
+    ScanlineRasterizer* r,
+    const PathPolyline& polyline,
+    double line_width) {
+  auto hw = line_width * 0.5;
+
+  // drop zero length segments
+  std::vector<vec2> vertices;
+  for (const auto& v : polyline.vertices) {
+    if (vertices.empty() ||
+        v.x != vertices.back().x ||
+        v.y != vertices.back().y) {
+      vertices.emplace_back(v);
+    }
+  }
+
+  auto closed = polyline.closed;
+  if (closed && vertices.size() > 1) {
+    const auto& first = vertices.front();
+    const auto& last = vertices.back();
+    if (first.x == last.x && first.y == last.y) {
+      vertices.pop_back();
+    }
+  }
+
+  if (vertices.size() < 2) {
+    return;
+  }
+
+  auto segment_count = closed ? vertices.size() : vertices.size() - 1;
+  for (size_t i = 0; i < segment_count; ++i) {
+    const auto& p0 = vertices[i];
+    const auto& p1 = vertices[(i + 1) % vertices.size()];
+    auto d = normalize(sub(p1, p0));
+    auto n = mul(vec2(-d.y, d.x), hw);
+
+    vec2 quad[4] = {
+      add(p0, n),
+      add(p1, n),
+      sub(p1, n),
+      sub(p0, n)
+    };
+
+    scanline_add_polygon_oriented(r, quad, 4);
+  }
+
+  for (size_t i = closed ? 0 : 1; i < segment_count; ++i) {
+    const auto& p = vertices[i];
+    const auto& p_prev = vertices[(i + vertices.size() - 1) % vertices.size()];
+    const auto& p_next = vertices[(i + 1) % vertices.size()];
+    auto d0 = normalize(sub(p, p_prev));
+    auto d1 = normalize(sub(p_next, p));
+
+    auto cross = d0.x * d1.y - d0.y * d1.x;
+    if (cross == 0) {
+      continue;
+    }
+
+    // the offsets point to the outer side of the join
+    auto side = cross > 0 ? -hw : hw;
+    auto o0 = mul(vec2(-d0.y, d0.x), side);
+    auto o1 = mul(vec2(-d1.y, d1.x), side);
+
+    // the miter length relative to the line width is 1 / sin(phi / 2) where
+    // phi is the angle between the two segments
+    auto sin_half_phi = sqrt(std::max((1.0 + dot(d0, d1)) * 0.5, 0.0));
+    auto miter_ratio = sin_half_phi > 0 ? 1.0 / sin_half_phi : 0;
+
+    if (miter_ratio > 0 && miter_ratio <= kScanlineMiterLimit) {
+      auto tip = add(p, mul(normalize(add(o0, o1)), hw * miter_ratio));
+      vec2 wedge[4] = { p, add(p, o0), tip, add(p, o1) };
+      scanline_add_polygon_oriented(r, wedge, 4);
+    } else {
+      vec2 wedge[3] = { p, add(p, o0), add(p, o1) };
+      scanline_add_polygon_oriented(r, wedge, 3);
+    }
+  }
+}
+
+ReturnCode scanline_stroke_path(
+    ScanlineRasterizer* r,
+    const ScanlineTarget& target,
+    const Path& path,
+    const StrokeStyle& style,
+    const std::optional<AntialiasingMode>& antialiasing_mode) {
+  double line_width = style.line_width;
+  if (line_width <= 0) {
+    return OK;
+  }
+
+  scanline_init(r, target.width, target.height);
+
+  std::vector<PathPolyline> polylines;
+  path_flatten(path, kScanlineFlattenTolerance, &polylines);
+
+  if (style.dash_type == StrokeStyle::DASH) {
+    std::vector<PathPolyline> dashes;
+    for (const auto& polyline : polylines) {
+      scanline_dash_polyline(polyline, style, &dashes);
+    }
+
+    polylines = std::move(dashes);
+  }
+
+  for (const auto& polyline : polylines) {
+    scanline_stroke_polyline(r, polyline, line_width);
+  }
+
+  scanline_flush(r, target, style.color, antialiasing_mode);
+  return OK;
+}
+
+} // namespace clip
+
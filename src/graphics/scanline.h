@@ -0,0 +1,95 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <optional>
+#include <stdint.h>
+#include <vector>
+#include "return_code.h"
+#include "style.h"
+#include "graphics/color.h"
+#include "graphics/image.h"
+#include "graphics/path.h"
+
+namespace clip {
+
+enum class ScanlinePixelFormat {
+  ARGB32_PREMULTIPLIED, RGBA8
+};
+
+/**
+ * A pixel buffer that the scanline rasterizer draws into. The top row is
+ * stored first and rows are `stride` bytes apart. ARGB32_PREMULTIPLIED pixels
+ * are 32-bit values in native byte order as used by cairo image surfaces;
+ * RGBA8 pixels are unpremultiplied bytes as used by the Image class.
+ */
+struct ScanlineTarget {
+  unsigned char* data;
+  uint32_t width;
+  uint32_t height;
+  size_t stride;
+  ScanlinePixelFormat format;
+};
+
+/**
+ * The scanline rasterizer computes the exact area that a shape covers in each
+ * pixel. The signed area of every edge is accumulated into a buffer and each
+ * row is then integrated with a prefix sum to get the coverage, similar to
+ * font-rs and stb_truetype.
+ *
+ * Areas with the same orientation are merged while areas with opposite
+ * orientations cancel out, which matches the non-zero winding rule for all
+ * shapes that do not overlap themselves with opposite orientations.
+ *
+ * The buffers are kept between calls and only the region that was touched by
+ * a shape is cleared, so drawing a shape does not allocate memory.
+ */
+struct ScanlineRasterizer {
+  ScanlineRasterizer();
+
+  uint32_t width;
+  uint32_t height;
+  std::vector<float> area;
+  std::vector<float> coverage;
+  uint32_t x_min;
+  uint32_t x_max;
+  uint32_t y_min;
+  uint32_t y_max;
+};
+
+ReturnCode scanline_target_image(Image* image, ScanlineTarget* target);
+
+/**
+ * Fill a path with a solid color. The path is given in pixel coordinates with
+ * the origin in the top left corner of the target.
+ */
+ReturnCode scanline_fill_path(
+    ScanlineRasterizer* rasterizer,
+    const ScanlineTarget& target,
+    const Path& path,
+    const Color& color,
+    const std::optional<AntialiasingMode>& antialiasing_mode);
+
+/**
+ * Stroke a path with butt caps and miter joins. The path is given in pixel
+ * coordinates with the origin in the top left corner of the target.
+ */
+ReturnCode scanline_stroke_path(
+    ScanlineRasterizer* rasterizer,
+    const ScanlineTarget& target,
+    const Path& path,
+    const StrokeStyle& style,
+    const std::optional<AntialiasingMode>& antialiasing_mode);
+
+} // namespace clip
+
@@ -23,7 +23,7 @@ namespace text {
 Status text_layout_span(
     const TextSpan& span,
     double dpi,
-    std::vector<GlyphPlacement>* glyphs,
+    GlyphPlacementList* glyphs,
     double* span_length,
     double* span_top,
     double* span_bottom) {
@@ -43,13 +43,24 @@ Status text_layout_span(
   }
 
   for (const auto& gi : glyph_list) {
-    GlyphPlacement gp;
-    gp.font = gi.font;
-    gp.codepoint = gi.codepoint;
-    gp.y = 0;
-    gp.x = *span_length;
-    gp.span_id = span.span_id;
-    glyphs->emplace_back(gp);
+    if (glyphs) {
+      GlyphPlacement gp;
+      gp.codepoint = gi.codepoint;
+      gp.y = 0;
+      gp.x = *span_length;
+      gp.span_id = span.span_id;
+      glyphs->glyphs.emplace_back(gp);
+
+      // extend the current run if the glyph has the same font
+      auto glyph_idx = glyphs->glyphs.size() - 1;
+      if (!glyphs->runs.empty() &&
+          glyphs->runs.back().font == gi.font &&
+          glyphs->runs.back().glyph_end == glyph_idx) {
+        glyphs->runs.back().glyph_end = glyph_idx + 1;
+      } else {
+        glyphs->runs.emplace_back(GlyphRun{gi.font, glyph_idx, glyph_idx + 1});
+      }
+    }
 
     *span_length += gi.advance_x;
     *span_top = std::max(gi.metrics_ascender, *span_top);
@@ -62,18 +73,18 @@ Status text_layout_span(
 Status text_layout_line(
     const TextLine& text_line,
     double dpi,
-    std::vector<GlyphPlacementGroup>* glyphs,
+    GlyphPlacementList* glyphs,
     Rectangle* bbox) {
   double line_top = 0.0;
   double line_bottom = 0.0;
   double line_length = 0;
   for (const auto& span : text_line.spans) {
     double span_length = 0.0;
-    std::vector<GlyphPlacement> span_glyphs;
+    size_t span_begin = glyphs ? glyphs->glyphs.size() : 0;
     auto rc = text_layout_span(
         span,
         dpi,
-        &span_glyphs,
+        glyphs,
         &span_length,
         &line_top,
         &line_bottom);
@@ -82,7 +93,8 @@ Status text_layout_line(
       return rc;
     }
 
-    for (auto& gi : span_glyphs) {
+    for (size_t i = span_begin; glyphs && i < glyphs->glyphs.size(); ++i) {
+      auto& gi = glyphs->glyphs[i];
       switch (text_line.base_direction) {
         case TextDirection::LTR:
           gi.x += line_length;
@@ -92,15 +104,6 @@ Status text_layout_line(
           gi.x -= span_length;
           break;
       }
-
-      // TODO merge glyph spans with the same font
-      GlyphPlacementGroup gg;
-      gg.font = gi.font;
-      gg.glyphs.emplace_back(gi);
-
-      if (glyphs) {
-        glyphs->emplace_back(gg);
-      }
     }
 
     line_length += span_length;
@@ -76,7 +76,6 @@ struct TextLine {
  * baseline of the (first) line of text is placed at (0, 0)
  */
 struct GlyphPlacement {
-  FontRef font;
   uint32_t codepoint;
   double x;
   double y;
@@ -85,19 +84,32 @@ struct GlyphPlacement {
 
 
 /**
- * A glyph placement group contains a list of placed glyphs where each glyph
- * has the same font
+ * A glyph run refers to a range of consecutive glyphs in a glyph placement
+ * list that all have the same font. The font is given as an index into the
+ * font stack of the text.
  */
-struct GlyphPlacementGroup {
-  FontRef font;
+struct GlyphRun {
+  uint32_t font;
+  size_t glyph_begin;
+  size_t glyph_end;
+};
+
+
+/**
+ * A glyph placement list contains all placed glyphs in a flat list and the
+ * runs of glyphs with the same font as offsets into that list
+ */
+struct GlyphPlacementList {
   std::vector<GlyphPlacement> glyphs;
+  std::vector<GlyphRun> runs;
 };
 
 
 /**
  * Layout a line of text. The text must already be itemized into spans so that
- * all text in each span has the same font, font size, script and writing
- * direction and so that spans are ordered "visually" (see above).
+ * all text in each span has the same font size, script and writing direction
+ * and so that spans are ordered "visually" (see above). All spans in the line
+ * must use the same font stack.
  *
  * Note that at this point only horizontal text lines are supported, vertical
  * writing direction is not yet implemented.
@@ -105,7 +117,7 @@ struct GlyphPlacementGroup {
 Status text_layout_line(
     const TextLine& text_line,
     double dpi,
-    std::vector<GlyphPlacementGroup>* glyphs,
+    GlyphPlacementList* glyphs,
     Rectangle* bbox);
 
 
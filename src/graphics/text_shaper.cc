@@ -12,9 +12,13 @@
  * limitations under the License.
  */
 #include "graphics/text_shaper.h"
+#include "utils/UTF8.h"
 
+#include <algorithm>
 #include <iostream>
 #include <functional>
+#include <list>
+#include <mutex>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <harfbuzz/hb.h>
@@ -26,7 +30,141 @@ using std::bind;
 namespace clip {
 namespace text {
 
-Status text_shape_run(
+/**
+ * HarfBuzz fonts are created once per thread, font and size. Each one is bound
+ * to the FreeType size object of its font size, so the font never needs to be
+ * rescaled. The FreeType faces they reference are owned by the thread state in
+ * font_lookup, which is created before and therefore destroyed after this one.
+ *
+ * The shaping buffer is reused for all runs shaped on the thread.
+ */
+struct ShaperThreadState {
+  ShaperThreadState() : buffer(hb_buffer_create()) {}
+  ~ShaperThreadState() {
+    for (const auto& f : fonts) {
+      hb_font_destroy(f.second);
+    }
+
+    hb_buffer_destroy(buffer);
+  }
+
+  std::unordered_map<const void*, hb_font_t*> fonts;
+  hb_buffer_t* buffer;
+};
+
+ShaperThreadState* text_shaper_thread_state() {
+  thread_local ShaperThreadState state;
+  return &state;
+}
+
+hb_font_t* text_shaper_get_font(FT_Face ft_font) {
+  auto state = text_shaper_thread_state();
+
+  auto& hb_font = state->fonts[ft_font->size];
+  if (!hb_font) {
+    hb_font = hb_ft_font_create_referenced(ft_font);
+  }
+
+  return hb_font;
+}
+
+/**
+ * The shape cache is a process-wide LRU cache of shaped runs. Fonts are never
+ * freed once they are loaded, so the font address can be used as a font id.
+ */
+static const size_t kShapeCacheSize = 8192;
+
+struct ShapeCacheKey {
+  std::string text;
+  const void* font;
+  double font_size;
+  double dpi;
+  TextDirection text_direction;
+  std::string language;
+  std::string script;
+
+  bool operator==(const ShapeCacheKey& o) const {
+    return
+        text == o.text &&
+        font == o.font &&
+        font_size == o.font_size &&
+        dpi == o.dpi &&
+        text_direction == o.text_direction &&
+        language == o.language &&
+        script == o.script;
+  }
+};
+
+struct ShapeCacheKeyHash {
+  size_t operator()(const ShapeCacheKey& k) const {
+    size_t h = std::hash<std::string>()(k.text);
+    auto combine = [&h] (size_t v) {
+      h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    };
+
+    combine(std::hash<const void*>()(k.font));
+    combine(std::hash<double>()(k.font_size));
+    combine(std::hash<double>()(k.dpi));
+    combine(static_cast<size_t>(k.text_direction));
+    combine(std::hash<std::string>()(k.language));
+    combine(std::hash<std::string>()(k.script));
+    return h;
+  }
+};
+
+struct ShapeCache {
+  using Entry = std::pair<ShapeCacheKey, std::vector<GlyphInfo>>;
+
+  std::mutex lock;
+  std::list<Entry> entries;
+  std::unordered_map<
+      ShapeCacheKey,
+      std::list<Entry>::iterator,
+      ShapeCacheKeyHash> index;
+};
+
+ShapeCache* text_shape_cache() {
+  static ShapeCache cache;
+  return &cache;
+}
+
+bool text_shape_cache_get(
+    const ShapeCacheKey& key,
+    std::vector<GlyphInfo>* glyphs) {
+  auto cache = text_shape_cache();
+
+  std::lock_guard<std::mutex> lk(cache->lock);
+  auto entry = cache->index.find(key);
+  if (entry == cache->index.end()) {
+    return false;
+  }
+
+  cache->entries.splice(cache->entries.begin(), cache->entries, entry->second);
+  const auto& entry_glyphs = entry->second->second;
+  glyphs->insert(glyphs->end(), entry_glyphs.begin(), entry_glyphs.end());
+  return true;
+}
+
+void text_shape_cache_put(
+    ShapeCacheKey&& key,
+    std::vector<GlyphInfo>&& glyphs) {
+  auto cache = text_shape_cache();
+
+  std::lock_guard<std::mutex> lk(cache->lock);
+  if (cache->index.count(key)) {
+    return;
+  }
+
+  cache->entries.emplace_front(std::move(key), std::move(glyphs));
+  cache->index.emplace(cache->entries.front().first, cache->entries.begin());
+
+  if (cache->entries.size() > kShapeCacheSize) {
+    cache->index.erase(cache->entries.back().first);
+    cache->entries.pop_back();
+  }
+}
+
+Status text_shape_run_uncached(
     const std::string& text,
     TextDirection text_direction,
     const std::string& language,
@@ -36,62 +174,52 @@ Status text_shape_run(
     double dpi,
     std::vector<GlyphInfo>* glyphs) {
   /* get freetype font */
-  auto ft_font = static_cast<FT_Face>(font_get_freetype(font));
-  auto font_size_ft = font_size * (72.0 / dpi) * 64;
-  if (FT_Set_Char_Size(ft_font, 0, font_size_ft, dpi, dpi)) {
+  auto ft_font = static_cast<FT_Face>(
+      font_get_freetype_sized(font, font_size, dpi));
+
+  if (!ft_font) {
     return ERROR;
   }
 
-  std::unique_ptr<
-      hb_font_t,
-      std::function<void (hb_font_t*)>>
-      hb_font(
-          hb_ft_font_create_referenced(ft_font),
-          bind(&hb_font_destroy, _1));
+  auto hb_font = text_shaper_get_font(ft_font);
 
   /* prepare buffer */
-  std::unique_ptr<
-      hb_buffer_t,
-      std::function<void (hb_buffer_t*)>>
-      hb_buf(
-          hb_buffer_create(),
-          bind(&hb_buffer_destroy, _1));
-
-  hb_buffer_reset(hb_buf.get());
+  auto hb_buf = text_shaper_thread_state()->buffer;
+  hb_buffer_clear_contents(hb_buf);
 
   if (!language.empty()) {
     hb_buffer_set_language(
-        hb_buf.get(),
+        hb_buf,
         hb_language_from_string(language.c_str(), language.length()));
   }
 
   if (!script.empty()) {
     hb_buffer_set_script(
-        hb_buf.get(),
+        hb_buf,
         hb_script_from_string(script.c_str(), script.length()));
   }
 
   switch (text_direction) {
     case TextDirection::LTR:
-      hb_buffer_set_direction(hb_buf.get(), HB_DIRECTION_LTR);
+      hb_buffer_set_direction(hb_buf, HB_DIRECTION_LTR);
       break;
     case TextDirection::RTL:
-      hb_buffer_set_direction(hb_buf.get(), HB_DIRECTION_RTL);
+      hb_buffer_set_direction(hb_buf, HB_DIRECTION_RTL);
       break;
   }
 
-  hb_buffer_add_utf8(hb_buf.get(), text.data(), text.size(), 0, text.size());
+  hb_buffer_add_utf8(hb_buf, text.data(), text.size(), 0, text.size());
 
   /* shape */
-  hb_shape(hb_font.get(), hb_buf.get(), NULL, 0);
+  hb_shape(hb_font, hb_buf, NULL, 0);
 
   /* output glyph info */
   uint32_t glyph_count;
-  auto glyph_infos = hb_buffer_get_glyph_infos(hb_buf.get(), &glyph_count);
-  auto glyph_positions = hb_buffer_get_glyph_positions(hb_buf.get(), &glyph_count);
+  auto glyph_infos = hb_buffer_get_glyph_infos(hb_buf, &glyph_count);
+  auto glyph_positions = hb_buffer_get_glyph_positions(hb_buf, &glyph_count);
   for (size_t i = 0; i < glyph_count; ++i) {
     GlyphInfo g;
-    g.font = font;
+    g.font = 0;
     g.codepoint = glyph_infos[i].codepoint;
     g.advance_x = glyph_positions[i].x_advance / 64.0;
     g.advance_y = glyph_positions[i].y_advance / 64.0;
@@ -103,52 +231,213 @@ Status text_shape_run(
   return OK;
 }
 
-Status text_shape_run_with_font_fallback(
+Status text_shape_run(
+    const std::string& text,
+    TextDirection text_direction,
+    const std::string& language,
+    const std::string& script,
+    FontRef font,
+    double font_size,
+    double dpi,
+    std::vector<GlyphInfo>* glyphs) {
+  ShapeCacheKey key;
+  key.text = text;
+  key.font = font.get();
+  key.font_size = font_size;
+  key.dpi = dpi;
+  key.text_direction = text_direction;
+  key.language = language;
+  key.script = script;
+
+  if (text_shape_cache_get(key, glyphs)) {
+    return OK;
+  }
+
+  std::vector<GlyphInfo> run_glyphs;
+  auto rc = text_shape_run_uncached(
+      text,
+      text_direction,
+      language,
+      script,
+      font,
+      font_size,
+      dpi,
+      &run_glyphs);
+
+  if (rc != OK) {
+    return rc;
+  }
+
+  glyphs->insert(glyphs->end(), run_glyphs.begin(), run_glyphs.end());
+  text_shape_cache_put(std::move(key), std::move(run_glyphs));
+  return OK;
+}
+
+/**
+ * Codepoints that extend the preceding character into one cluster, i.e.
+ * combining marks, joiners and variation selectors. They are always shaped with
+ * the font of the preceding character.
+ */
+bool text_is_cluster_extend(uint32_t codepoint) {
+  return
+      (codepoint >= 0x0300 && codepoint <= 0x036F) ||
+      (codepoint >= 0x1AB0 && codepoint <= 0x1AFF) ||
+      (codepoint >= 0x1DC0 && codepoint <= 0x1DFF) ||
+      (codepoint >= 0x200C && codepoint <= 0x200D) ||
+      (codepoint >= 0x20D0 && codepoint <= 0x20FF) ||
+      (codepoint >= 0xFE00 && codepoint <= 0xFE0F) ||
+      (codepoint >= 0xFE20 && codepoint <= 0xFE2F) ||
+      (codepoint >= 0xE0100 && codepoint <= 0xE01EF);
+}
+
+struct FontRun {
+  size_t font;
+  size_t begin;
+  size_t end;
+};
+
+/**
+ * Split the text into runs by the first font that has a glyph for each
+ * codepoint. Codepoints that no font covers are assigned to the first font so
+ * that they are rendered as its missing glyph.
+ */
+void text_itemize_fonts(
+    const std::string& text,
+    const FontRef* fonts,
+    size_t font_count,
+    std::vector<FontRun>* runs) {
+  const char* begin = text.data();
+  const char* end = text.data() + text.size();
+  const char* cur = begin;
+
+  try {
+    while (cur < end) {
+      size_t run_begin = cur - begin;
+      auto codepoint = UTF8::nextCodepoint(&cur, end);
+
+      if (!runs->empty() && text_is_cluster_extend(codepoint)) {
+        runs->back().end = cur - begin;
+        continue;
+      }
+
+      size_t font = 0;
+      for (size_t i = 0; i < font_count; ++i) {
+        if (font_has_codepoint(fonts[i], codepoint)) {
+          font = i;
+          break;
+        }
+      }
+
+      if (!runs->empty() && runs->back().font == font) {
+        runs->back().end = cur - begin;
+      } else {
+        runs->emplace_back(FontRun{font, run_begin, size_t(cur - begin)});
+      }
+    }
+  } catch (...) {
+    // invalid UTF-8; shape the remainder with the first font
+    auto rest = size_t(runs->empty() ? 0 : runs->back().end);
+    if (rest < text.size()) {
+      runs->emplace_back(FontRun{0, rest, text.size()});
+    }
+  }
+}
+
+Status text_shape_run_with_fonts(
     const std::string& text,
     TextDirection text_direction,
     const std::string& text_language,
     const std::string& text_script,
-    const FontInfo& font_info,
+    const FontRef* fonts,
+    size_t font_count,
     double font_size,
     double dpi,
     std::vector<GlyphInfo>* glyphs) {
+  if (font_count == 0) {
+    return OK;
+  }
+
+  std::vector<FontRun> runs;
+  text_itemize_fonts(text, fonts, font_count, &runs);
 
-  std::vector<GlyphInfo> font_glyphs;
-  for (const auto& font : font_info.fonts) {
-    font_glyphs.clear();
+  std::vector<std::vector<GlyphInfo>> run_glyphs(runs.size());
+  for (size_t i = 0; i < runs.size(); ++i) {
+    const auto& run = runs[i];
+    auto run_text = text.substr(run.begin, run.end - run.begin);
 
     auto rc = text_shape_run(
-        text,
+        run_text,
         text_direction,
         text_language,
         text_script,
-        font,
+        fonts[run.font],
         font_size,
         dpi,
-        &font_glyphs);
+        &run_glyphs[i]);
+
+    auto run_font = run.font;
+
+    // fallback fonts are opened lazily, so a broken font file is only noticed
+    // here; shape the run with the remaining fonts instead
+    if (rc != OK && run.font + 1 < font_count) {
+      run_glyphs[i].clear();
+      rc = text_shape_run_with_fonts(
+          run_text,
+          text_direction,
+          text_language,
+          text_script,
+          fonts + run.font + 1,
+          font_count - run.font - 1,
+          font_size,
+          dpi,
+          &run_glyphs[i]);
+
+      run_font = run.font + 1;
+    }
 
     if (rc != OK) {
       return rc;
     }
 
-    bool font_ok = true;
-    for (const auto& g : font_glyphs) {
-      if (g.codepoint == 0) {
-        font_ok = false;
-        break;
-      }
+    for (auto& g : run_glyphs[i]) {
+      g.font += run_font;
     }
+  }
 
-    if (font_ok) {
-      break;
-    }
+  // the glyphs of each run are in visual order, so for right-to-left text the
+  // runs themselves must be reversed as well
+  if (text_direction == TextDirection::RTL) {
+    std::reverse(run_glyphs.begin(), run_glyphs.end());
   }
 
-  glyphs->insert(glyphs->end(), font_glyphs.begin(), font_glyphs.end());
+  for (const auto& r : run_glyphs) {
+    glyphs->insert(glyphs->end(), r.begin(), r.end());
+  }
 
   return OK;
 }
 
+Status text_shape_run_with_font_fallback(
+    const std::string& text,
+    TextDirection text_direction,
+    const std::string& text_language,
+    const std::string& text_script,
+    const FontInfo& font_info,
+    double font_size,
+    double dpi,
+    std::vector<GlyphInfo>* glyphs) {
+  return text_shape_run_with_fonts(
+      text,
+      text_direction,
+      text_language,
+      text_script,
+      font_info.stack->fonts.data(),
+      font_info.stack->fonts.size(),
+      font_size,
+      dpi,
+      glyphs);
+}
+
 } // namespace text
 } // namespace clip
 
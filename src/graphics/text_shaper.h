@@ -21,8 +21,12 @@
 namespace clip {
 namespace text {
 
+/**
+ * A shaped glyph. The font is given as the index of the font in the font stack
+ * that was used for shaping; it is always zero for text_shape_run.
+ */
 struct GlyphInfo {
-  FontRef font;
+  uint32_t font;
   uint32_t codepoint;
   double advance_y;
   double advance_x;
@@ -33,6 +37,9 @@ struct GlyphInfo {
 /**
  * Shape a "run" of text with a given font and a given text direction. The
  * text must be provided as a UTF-8 string in logical character order.
+ *
+ * Shaped runs are stored in a bounded, process-wide LRU cache, so measuring
+ * and drawing the same label shapes it only once.
  */
 Status text_shape_run(
     const std::string& text,
@@ -45,7 +52,9 @@ Status text_shape_run(
     std::vector<GlyphInfo>* glyphs);
 
 /**
- * Shape a "run" of UTF-8 text in logical character order with font fallback
+ * Shape a "run" of UTF-8 text in logical character order with font fallback.
+ * The text is split into runs by the first font that covers each character and
+ * each of these runs is shaped once with its font.
  */
 Status text_shape_run_with_font_fallback(
     const std::string& text,
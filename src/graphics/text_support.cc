@@ -14,12 +14,68 @@
 #include "text_backend.h"
 #include "text_support.h"
 #include "text_layout.h"
+#include "utils/UTF8.h"
 
+#include <algorithm>
 #include <numeric>
 
 namespace clip::text {
 
+bool text_is_ltr_only(const std::string& text) {
+  const char* cur = text.data();
+  const char* end = text.data() + text.size();
+
+  try {
+    while (cur < end) {
+      // ASCII text never contains right-to-left characters
+      if (static_cast<unsigned char>(*cur) < 0x80) {
+        ++cur;
+        continue;
+      }
+
+      auto codepoint = UTF8::nextCodepoint(&cur, end);
+
+      // right-to-left scripts and presentation forms
+      if ((codepoint >= 0x0590 && codepoint <= 0x08FF) ||
+          (codepoint >= 0xFB1D && codepoint <= 0xFDFF) ||
+          (codepoint >= 0xFE70 && codepoint <= 0xFEFF) ||
+          (codepoint >= 0x10800 && codepoint <= 0x10FFF) ||
+          (codepoint >= 0x1E800 && codepoint <= 0x1EFFF)) {
+        return false;
+      }
+
+      // explicit directional marks, embeddings, overrides and isolates
+      if (codepoint == 0x200F ||
+          (codepoint >= 0x202A && codepoint <= 0x202E) ||
+          (codepoint >= 0x2066 && codepoint <= 0x2069)) {
+        return false;
+      }
+    }
+  } catch (...) {
+    return false;
+  }
+
+  return true;
+}
+
 ReturnCode text_reorder_bidi_line(TextLine* line) {
+  // a left-to-right line without any right-to-left characters is already in
+  // visual order, so the bidi analysis can be skipped
+  auto ltr_only = [line] {
+    return std::all_of(
+        line->spans.begin(),
+        line->spans.end(),
+        [] (const TextSpan& span) { return text_is_ltr_only(span.text); });
+  };
+
+  if (line->base_direction == TextDirection::LTR && ltr_only()) {
+    for (auto& span : line->spans) {
+      span.text_direction = TextDirection::LTR;
+    }
+
+    return OK;
+  }
+
   std::vector<TextSpan> spans;
 
   // Split spans of the line using the unicode bidi algorithm and extract the
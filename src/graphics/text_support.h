@@ -16,11 +16,19 @@
 
 namespace clip::text {
 
+/**
+ * Check if the UTF-8 text contains no right-to-left characters and no explicit
+ * directional formatting characters. Such text is laid out left-to-right in a
+ * left-to-right line without any bidi analysis.
+ */
+bool text_is_ltr_only(const std::string& text);
+
 /**
  * Itemize the spans in a line by text directionality and reorder them into
  * "visual order" according to the unicode bidi algorithm. Note that only
  * the spans are re-ordered into visual order; text within spans stays in logical
- * order.
+ * order. Left-to-right lines that only contain left-to-right text are returned
+ * unchanged.
  */
 ReturnCode text_reorder_bidi_line(TextLine* line);
 
@@ -268,26 +268,26 @@ ReturnCode areas_draw(
   c->fill_style.color = ctx->foreground_color;
 
   /* parse properties */
-  std::vector<std::string> data_x;
-  std::vector<std::string> data_y;
-  std::vector<std::string> data_xoffset;
-  std::vector<std::string> data_yoffset;
+  DataValues data_x;
+  DataValues data_y;
+  DataValues data_xoffset;
+  DataValues data_yoffset;
 
   auto config_rc = expr_walk_map_with_defaults(expr_next(expr), ctx->defaults, {
-    {"data-x", bind(&data_load, _1, &c->x)},
-    {"data-y", bind(&data_load, _1, &c->y)},
-    {"data-x-high", bind(&data_load, _1, &c->x)},
-    {"data-y-high", bind(&data_load, _1, &c->y)},
-    {"data-x-low", bind(&data_load, _1, &c->xoffset)},
-    {"data-y-low", bind(&data_load, _1, &c->yoffset)},
+    {"data-x", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-y", bind(&data_load_values, ctx, _1, &data_y)},
+    {"data-x-high", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-y-high", bind(&data_load_values, ctx, _1, &data_y)},
+    {"data-x-low", bind(&data_load_values, ctx, _1, &data_xoffset)},
+    {"data-y-low", bind(&data_load_values, ctx, _1, &data_yoffset)},
     {"limit-x", bind(&expr_to_float64_opt_pair, _1, &c->scale_x.min, &c->scale_x.max)},
     {"limit-x-min", bind(&expr_to_float64_opt, _1, &c->scale_x.min)},
     {"limit-x-max", bind(&expr_to_float64_opt, _1, &c->scale_x.max)},
     {"limit-y", bind(&expr_to_float64_opt_pair, _1, &c->scale_y.min, &c->scale_y.max)},
     {"limit-y-min", bind(&expr_to_float64_opt, _1, &c->scale_y.min)},
     {"limit-y-max", bind(&expr_to_float64_opt, _1, &c->scale_y.max)},
-    {"scale-x", bind(&scale_configure_kind, _1, &c->scale_x)},
-    {"scale-y", bind(&scale_configure_kind, _1, &c->scale_y)},
+    {"scale-x", bind(&scale_configure_kind, ctx, _1, &c->scale_x)},
+    {"scale-y", bind(&scale_configure_kind, ctx, _1, &c->scale_y)},
     {"scale-x-padding", bind(&expr_to_float64, _1, &c->scale_x.padding)},
     {"scale-y-padding", bind(&expr_to_float64, _1, &c->scale_y.padding)},
     {
@@ -85,6 +85,12 @@ struct AxisDefinition {
 
   /* border */
   StrokeStyle border_style;
+
+  /* text layout; computed once by axis_layout_text and reused when drawing */
+  std::optional<std::vector<TextLayout>> label_layouts;
+  double label_size;
+  std::optional<TextLayout> title_layout;
+  double title_size;
 };
 
 AxisDefinition::AxisDefinition() :
@@ -94,7 +100,9 @@ AxisDefinition::AxisDefinition() :
     title_rotate(0.0),
     tick_offset(0.0),
     label_offset(0.0),
-    label_rotate(0.0) {}
+    label_rotate(0.0),
+    label_size(0.0),
+    title_size(0.0) {}
 
 void axis_convert_units(AxisDefinition* config, const Context* ctx) {
   convert_unit_typographic(
@@ -128,136 +136,151 @@ void axis_convert_units(AxisDefinition* config, const Context* ctx) {
       &config->tick_length);
 }
 
+/**
+ * Lay out the labels of the axis and compute the size they require
+ */
 ReturnCode axis_layout_labels(
-    const AxisDefinition& axis,
-    const Context* ctx,
-    double* margin) {
+    AxisDefinition* axis,
+    const Context* ctx) {
   /* compute scale layout */
   ScaleLayout labels;
-  axis.label_placement(axis.scale, axis.label_formatter, &labels);
+  axis->label_placement(axis->scale, axis->label_formatter, &labels);
 
-  /* compute label margin */
-  double label_margin = 0;
-  for (size_t i = 0; i < labels.positions.size(); ++i) {
-    auto tick = labels.positions[i];
-    auto label_text = labels.labels[i];
-
-    TextStyle style;
-    style.font = axis.label_font;
-    style.font_size = axis.label_font_size;
-
-    Rectangle label_bbox;
-    if (auto rc = text_measure_label(
-          label_text,
-          TextDirection::LTR,
-          axis.label_font,
-          axis.label_font_size,
-          ctx->dpi,
-          &label_bbox);
-         rc != Status::OK) {
-      return rc;
-    }
+  /* layout labels */
+  TextStyle style;
+  style.font = axis->label_font;
+  style.color = axis->label_color;
+  style.font_size = axis->label_font_size;
+
+  std::vector<TextLayout> layouts;
+  if (auto rc = text_layout_labels(ctx, labels.labels, style, &layouts); !rc) {
+    return rc;
+  }
 
-    if (axis.label_rotate) {
-      label_bbox = box_rotate_bounds(label_bbox, axis.label_rotate);
+  /* compute label size */
+  double label_size = 0;
+  for (const auto& label_layout : layouts) {
+    auto label_bbox = label_layout.bbox;
+
+    if (axis->label_rotate) {
+      label_bbox = box_rotate_bounds(label_bbox, axis->label_rotate);
     }
 
-    switch (axis.align) {
+    switch (axis->align) {
       case AxisAlign::X:
       case AxisAlign::TOP:
       case AxisAlign::BOTTOM:
-        label_margin = std::max(label_margin, label_bbox.h);
-        break;
+        label_size = std::max(label_size, label_bbox.h);
         break;
       case AxisAlign::Y:
       case AxisAlign::LEFT:
       case AxisAlign::RIGHT:
-        label_margin = std::max(label_margin, label_bbox.w);
+        label_size = std::max(label_size, label_bbox.w);
         break;
     }
   }
 
-  *margin += label_margin;
+  axis->label_layouts = std::move(layouts);
+  axis->label_size = label_size;
   return OK;
 }
 
+/**
+ * Lay out the title of the axis and compute the size it requires
+ */
 ReturnCode axis_layout_title(
-    const AxisDefinition& axis,
-    const Context* ctx,
-    double* margin) {
-  Rectangle title_bbox;
-  if (auto rc = text_measure_label(
-        axis.title,
-        TextDirection::LTR,
-        axis.title_font,
-        axis.title_font_size,
-        ctx->dpi,
-        &title_bbox);
-       rc != Status::OK) {
+    AxisDefinition* axis,
+    const Context* ctx) {
+  TextStyle style;
+  style.font = axis->title_font;
+  style.color = axis->title_color;
+  style.font_size = axis->title_font_size;
+
+  TextLayout layout;
+  if (auto rc = text_layout_label(ctx, axis->title, style, &layout); !rc) {
     return rc;
   }
 
-  if (axis.title_rotate) {
-    title_bbox = box_rotate_bounds(title_bbox, axis.title_rotate);
+  auto title_bbox = layout.bbox;
+
+  if (axis->title_rotate) {
+    title_bbox = box_rotate_bounds(title_bbox, axis->title_rotate);
   }
 
-  switch (axis.align) {
+  switch (axis->align) {
     case AxisAlign::X:
     case AxisAlign::LEFT:
     case AxisAlign::RIGHT:
-      *margin += title_bbox.w;
+      axis->title_size = title_bbox.w;
       break;
     case AxisAlign::Y:
     case AxisAlign::TOP:
     case AxisAlign::BOTTOM:
-      *margin += title_bbox.h;
-      break;
+      axis->title_size = title_bbox.h;
       break;
   }
 
+  axis->title_layout = std::move(layout);
+  return OK;
+}
+
+/**
+ * Lay out the labels and the title of the axis unless they were already laid
+ * out, so that the text of each axis is only shaped once per render
+ */
+ReturnCode axis_layout_text(
+    AxisDefinition* axis,
+    const Context* ctx) {
+  if (!axis->label_layouts) {
+    if (auto rc = axis_layout_labels(axis, ctx); !rc) {
+      return rc;
+    }
+  }
+
+  if (!axis->title.empty() && !axis->title_layout) {
+    if (auto rc = axis_layout_title(axis, ctx); !rc) {
+      return rc;
+    }
+  }
+
   return OK;
 }
 
 ReturnCode axis_layout(
-    const AxisDefinition& axis_config,
+    AxisDefinition* axis,
     const Context* ctx,
     double* margin) {
-  auto axis = axis_config;
-  axis_convert_units(&axis, ctx);
+  if (auto rc = axis_layout_text(axis, ctx); !rc) {
+    return rc;
+  }
 
   /* add margin for the labels */
-  {
-    *margin += measure_or(
-        axis.label_padding,
-        from_em(kDefaultLabelPaddingEM, axis.label_font_size));
+  *margin += measure_or(
+      axis->label_padding,
+      from_em(kDefaultLabelPaddingEM, axis->label_font_size));
 
-    if (auto rc = axis_layout_labels(axis, ctx, margin); !rc) {
-      return rc;
-    }
-  }
+  *margin += axis->label_size;
 
   /* add margin for the title */
-  if (!axis.title.empty()) {
-    switch (axis.align) {
+  if (!axis->title.empty()) {
+    switch (axis->align) {
       case AxisAlign::X:
       case AxisAlign::TOP:
       case AxisAlign::BOTTOM:
         *margin += measure_or(
-                axis.title_padding,
-                from_em(kDefaultTitlePaddingVertEM, axis.title_font_size));
+                axis->title_padding,
+                from_em(kDefaultTitlePaddingVertEM, axis->title_font_size));
         break;
       case AxisAlign::Y:
       case AxisAlign::LEFT:
       case AxisAlign::RIGHT:
         *margin += measure_or(
-                axis.title_padding,
-                from_em(kDefaultTitlePaddingHorizEM, axis.title_font_size));
+                axis->title_padding,
+                from_em(kDefaultTitlePaddingHorizEM, axis->title_font_size));
         break;
     }
 
-    if (auto rc = axis_layout_title(axis, ctx, margin); !rc) {
-      return rc;
-    }
+    *margin += axis->title_size;
   }
 
   return OK;
@@ -311,25 +334,16 @@ static ReturnCode axis_draw_vertical(
       axis_config.label_padding,
       from_em(kDefaultLabelPaddingEM, axis_config.label_font_size));
 
-  double label_size = 0;
-  if (auto rc = axis_layout_labels(axis_config, ctx, &label_size);
-      !rc) {
-    return rc;
-  }
+  const auto& label_layouts = *axis_config.label_layouts;
+  auto label_size = axis_config.label_size;
 
   for (size_t i = 0; i < labels.positions.size(); ++i) {
     auto tick = labels.positions[i];
-    auto label_text = labels.labels[i];
 
     Point p;
     p.x = x + label_padding * label_position;
     p.y = y0 + (y1 - y0) * tick;
 
-    TextStyle style;
-    style.font = axis_config.label_font;
-    style.color = axis_config.label_color;
-    style.font_size = axis_config.label_font_size;
-
     auto a = axis_config.label_rotate;
     HAlign ax;
     VAlign ay;
@@ -353,7 +367,7 @@ static ReturnCode axis_draw_vertical(
         break;
     }
 
-    if (auto rc = draw_text(ctx, label_text, p, ax, ay, a, style); rc != OK) {
+    if (auto rc = draw_text(ctx, label_layouts[i], p, ax, ay, a); !rc) {
       return rc;
     }
   }
@@ -371,31 +385,21 @@ static ReturnCode axis_draw_vertical(
       title_padding += label_size + label_padding;
     }
 
-    double title_size = 0;
-    if (auto rc =
-          axis_layout_title(axis_config, ctx, &title_size);
-        !rc) {
-      return rc;
-    }
+    const auto& title_layout = *axis_config.title_layout;
+    auto title_size = axis_config.title_size;
 
     Point p;
     p.x = x + (title_padding + title_size * 0.5) * title_position;
     p.y = y0 + (y1 - y0) * 0.5;
 
-    TextStyle style;
-    style.font = axis_config.title_font;
-    style.color = axis_config.title_color;
-    style.font_size = axis_config.title_font_size;
-
     auto draw_rc =
       draw_text(
           ctx,
-          axis_config.title,
+          title_layout,
           p,
           HAlign::CENTER,
           VAlign::CENTER,
-          axis_config.title_rotate,
-          style);
+          axis_config.title_rotate);
 
     if (!draw_rc) {
       return draw_rc;
@@ -452,24 +456,16 @@ static ReturnCode axis_draw_horizontal(
       axis_config.label_padding,
       from_em(kDefaultLabelPaddingEM, axis_config.label_font_size));
 
-  double label_size = 0;
-  if (auto rc = axis_layout_labels(axis_config, ctx, &label_size); !rc) {
-    return rc;
-  }
+  const auto& label_layouts = *axis_config.label_layouts;
+  auto label_size = axis_config.label_size;
 
   for (size_t i = 0; i < labels.positions.size(); ++i) {
     auto tick = labels.positions[i];
-    auto label_text = labels.labels[i];
 
     Point p;
     p.x = x0 + (x1 - x0) * tick;
     p.y = y + label_padding * label_position;
 
-    TextStyle style;
-    style.font = axis_config.label_font;
-    style.color = axis_config.label_color;
-    style.font_size = axis_config.label_font_size;
-
     auto a = axis_config.label_rotate;
     HAlign ax;
     VAlign ay;
@@ -493,7 +489,7 @@ static ReturnCode axis_draw_horizontal(
         break;
     }
 
-    if (auto rc = draw_text(ctx, label_text, p, ax, ay, a, style); !rc) {
+    if (auto rc = draw_text(ctx, label_layouts[i], p, ax, ay, a); !rc) {
       return rc;
     }
   }
@@ -511,28 +507,20 @@ static ReturnCode axis_draw_horizontal(
       title_padding += label_size + label_padding;
     }
 
-    double title_size = 0;
-    if (auto rc = axis_layout_title(axis_config, ctx, &title_size); !rc) {
-      return rc;
-    }
+    const auto& title_layout = *axis_config.title_layout;
+    auto title_size = axis_config.title_size;
 
     Point p;
     p.x = x0 + (x1 - x0) * 0.5;
     p.y = y + (title_padding + title_size * 0.5) * title_position;
 
-    TextStyle style;
-    style.font = axis_config.title_font;
-    style.color = axis_config.title_color;
-    style.font_size = axis_config.title_font_size;
-
     auto draw_rc = draw_text(
         ctx,
-        axis_config.title,
+        title_layout,
         p,
         HAlign::CENTER,
         VAlign::CENTER,
-        axis_config.title_rotate,
-        style);
+        axis_config.title_rotate);
 
     if (!draw_rc) {
       return draw_rc;
@@ -565,6 +553,10 @@ ReturnCode axis_prepare(
 ReturnCode axis_draw(
     Context* ctx,
     AxisDefinition* config) {
+  if (auto rc = axis_layout_text(config, ctx); !rc) {
+    return rc;
+  }
+
   const auto& axis = *config;
   const auto& bbox = context_get_clip(ctx);
 
@@ -701,7 +693,7 @@ ReturnCode axis_draw(Context* ctx, const Expr* expr) {
   {
     auto rc = expr_walk_map_with_defaults(expr_next(expr), ctx->defaults, {
       /* scale options */
-      {"scale", bind(&scale_configure_kind, _1, &config->scale)},
+      {"scale", bind(&scale_configure_kind, ctx, _1, &config->scale)},
       {"limit", bind(&expr_to_float64_opt_pair, _1, &config->scale.min, &config->scale.max)},
       {"limit-min", bind(&expr_to_float64_opt, _1, &config->scale.min)},
       {"limit-max", bind(&expr_to_float64_opt, _1, &config->scale.max)},
@@ -709,7 +701,7 @@ ReturnCode axis_draw(Context* ctx, const Expr* expr) {
       /* label options */
       {"label-font", expr_call_string_fn(bind(&font_load_best, _1, &config->label_font))},
       {"label-placement", bind(&scale_configure_layout, _1, &config->label_placement)},
-      {"label-format", bind(&format_configure, _1, &config->label_formatter)},
+      {"label-format", bind(&format_configure, ctx, _1, &config->label_formatter)},
       {
         "label-attach",
         expr_to_enum_fn<AxisLabelAttach>(&config->label_attach, {
@@ -885,21 +877,21 @@ ReturnCode axis_add_all(Context* ctx, const Expr* expr) {
     {
       "scale-x",
       expr_calln_fn({
-        bind(&scale_configure_kind, _1, &axes[0].scale),
-        bind(&scale_configure_kind, _1, &axes[2].scale),
+        bind(&scale_configure_kind, ctx, _1, &axes[0].scale),
+        bind(&scale_configure_kind, ctx, _1, &axes[2].scale),
       })
     },
     {
       "scale-y",
       expr_calln_fn({
-        bind(&scale_configure_kind, _1, &axes[1].scale),
-        bind(&scale_configure_kind, _1, &axes[3].scale),
+        bind(&scale_configure_kind, ctx, _1, &axes[1].scale),
+        bind(&scale_configure_kind, ctx, _1, &axes[3].scale),
       })
     },
-    {"scale-top", bind(&scale_configure_kind, _1, &axes[0].scale)},
-    {"scale-right", bind(&scale_configure_kind, _1, &axes[1].scale)},
-    {"scale-bottom", bind(&scale_configure_kind, _1, &axes[2].scale)},
-    {"scale-left", bind(&scale_configure_kind, _1, &axes[3].scale)},
+    {"scale-top", bind(&scale_configure_kind, ctx, _1, &axes[0].scale)},
+    {"scale-right", bind(&scale_configure_kind, ctx, _1, &axes[1].scale)},
+    {"scale-bottom", bind(&scale_configure_kind, ctx, _1, &axes[2].scale)},
+    {"scale-left", bind(&scale_configure_kind, ctx, _1, &axes[3].scale)},
 
     {
       "limit-x",
@@ -942,24 +934,24 @@ ReturnCode axis_add_all(Context* ctx, const Expr* expr) {
     {
       "label-format",
       expr_calln_fn({
-        bind(&format_configure, _1, &axes[0].label_formatter),
-        bind(&format_configure, _1, &axes[1].label_formatter),
-        bind(&format_configure, _1, &axes[2].label_formatter),
-        bind(&format_configure, _1, &axes[3].label_formatter)
+        bind(&format_configure, ctx, _1, &axes[0].label_formatter),
+        bind(&format_configure, ctx, _1, &axes[1].label_formatter),
+        bind(&format_configure, ctx, _1, &axes[2].label_formatter),
+        bind(&format_configure, ctx, _1, &axes[3].label_formatter)
       })
     },
     {
       "label-format-x",
       expr_calln_fn({
-        bind(&format_configure, _1, &axes[0].label_formatter),
-        bind(&format_configure, _1, &axes[2].label_formatter)
+        bind(&format_configure, ctx, _1, &axes[0].label_formatter),
+        bind(&format_configure, ctx, _1, &axes[2].label_formatter)
       })
     },
     {
       "label-format-y",
       expr_calln_fn({
-        bind(&format_configure, _1, &axes[1].label_formatter),
-        bind(&format_configure, _1, &axes[3].label_formatter)
+        bind(&format_configure, ctx, _1, &axes[1].label_formatter),
+        bind(&format_configure, ctx, _1, &axes[3].label_formatter)
       })
     },
     {
@@ -1010,10 +1002,10 @@ ReturnCode axis_add_all(Context* ctx, const Expr* expr) {
     {"label-rotate-right", bind(&expr_to_float64, _1, &axes[1].label_rotate)},
     {"label-rotate-bottom", bind(&expr_to_float64, _1, &axes[2].label_rotate)},
     {"label-rotate-left", bind(&expr_to_float64, _1, &axes[3].label_rotate)},
-    {"label-format-top", bind(&format_configure, _1, &axes[0].label_formatter)},
-    {"label-format-right", bind(&format_configure, _1, &axes[1].label_formatter)},
-    {"label-format-bottom", bind(&format_configure, _1, &axes[2].label_formatter)},
-    {"label-format-left", bind(&format_configure, _1, &axes[3].label_formatter)},
+    {"label-format-top", bind(&format_configure, ctx, _1, &axes[0].label_formatter)},
+    {"label-format-right", bind(&format_configure, ctx, _1, &axes[1].label_formatter)},
+    {"label-format-bottom", bind(&format_configure, ctx, _1, &axes[2].label_formatter)},
+    {"label-format-left", bind(&format_configure, ctx, _1, &axes[3].label_formatter)},
     {
       "label-font-size",
       expr_calln_fn({
@@ -1286,7 +1278,9 @@ ReturnCode axis_add_all(Context* ctx, const Expr* expr) {
       return rc;
     }
 
-    axis_layout(axes[i], ctx, &padding[i]);
+    if (auto rc = axis_layout(&axes[i], ctx, &padding[i]); !rc) {
+      return rc;
+    }
   }
 
   auto bbox = layout_margin_box(
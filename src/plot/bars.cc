@@ -143,9 +143,19 @@ ReturnCode draw_horizontal(
   }
 
   /* draw labels */
-  for (size_t i = 0; i < config.labels.size(); ++i) {
-    const auto& text = config.labels[i];
+  TextStyle label_style;
+  label_style.font = config.label_font;
+  label_style.color = config.label_color;
+  label_style.font_size = config.label_font_size;
+
+  std::vector<TextLayout> label_layouts;
+  if (auto rc =
+        text_layout_labels(ctx, config.labels, label_style, &label_layouts);
+      !rc) {
+    return rc;
+  }
 
+  for (size_t i = 0; i < config.labels.size(); ++i) {
     auto offset = config.offsets.empty()
         ? 0
         : config.offsets[i % config.offsets.size()];
@@ -158,14 +168,9 @@ ReturnCode draw_horizontal(
         clip.x + config.x[i] + padding,
         clip.y + -offset + config.y[i]);
 
-    TextStyle style;
-    style.font = config.label_font;
-    style.color = config.label_color;
-    style.font_size = config.label_font_size;
-
     auto ax = HAlign::LEFT;
     auto ay = VAlign::CENTER;
-    if (auto rc = draw_text(ctx, text, p, ax, ay, style); rc != OK) {
+    if (auto rc = draw_text(ctx, label_layouts[i], p, ax, ay, 0); !rc) {
       return rc;
     }
   }
@@ -257,9 +262,19 @@ ReturnCode draw_vertical(
   }
 
   /* draw labels */
-  for (size_t i = 0; i < config.labels.size(); ++i) {
-    const auto& text = config.labels[i];
+  TextStyle label_style;
+  label_style.font = config.label_font;
+  label_style.color = config.label_color;
+  label_style.font_size = config.label_font_size;
+
+  std::vector<TextLayout> label_layouts;
+  if (auto rc =
+        text_layout_labels(ctx, config.labels, label_style, &label_layouts);
+      !rc) {
+    return rc;
+  }
 
+  for (size_t i = 0; i < config.labels.size(); ++i) {
     auto offset = config.offsets.empty()
         ? 0
         : config.offsets[i % config.offsets.size()];
@@ -272,14 +287,9 @@ ReturnCode draw_vertical(
         clip.x + offset + config.x[i],
         clip.y + config.y[i] + padding);
 
-    TextStyle style;
-    style.font = config.label_font;
-    style.color = config.label_color;
-    style.font_size = config.label_font_size;
-
     auto ax = HAlign::CENTER;
     auto ay = VAlign::BOTTOM;
-    if (auto rc = draw_text(ctx, text, p, ax, ay, style); rc != OK) {
+    if (auto rc = draw_text(ctx, label_layouts[i], p, ax, ay, 0); !rc) {
       return rc;
     }
   }
@@ -312,22 +322,22 @@ ReturnCode bars_draw(
   c->label_font_size = ctx->font_size;
 
   /* parse properties */
-  std::vector<std::string> data_x;
-  std::vector<std::string> data_y;
-  std::vector<std::string> data_xoffset;
-  std::vector<std::string> data_yoffset;
+  DataValues data_x;
+  DataValues data_y;
+  DataValues data_xoffset;
+  DataValues data_yoffset;
 
   auto config_rc = expr_walk_map_with_defaults(expr_next(expr), ctx->defaults, {
-    {"data-x", bind(&data_load_strings, _1, &data_x)},
-    {"data-y", bind(&data_load_strings, _1, &data_y)},
-    {"data-x-high", bind(&data_load_strings, _1, &data_x)},
-    {"data-y-high", bind(&data_load_strings, _1, &data_y)},
-    {"data-x-low", bind(&data_load_strings, _1, &data_xoffset)},
-    {"data-y-low", bind(&data_load_strings, _1, &data_yoffset)},
-    {"width", bind(&data_load, _1, &c->sizes)},
-    {"widths", bind(&data_load, _1, &c->sizes)},
-    {"offset", bind(&data_load, _1, &c->offsets)},
-    {"offsets", bind(&data_load, _1, &c->offsets)},
+    {"data-x", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-y", bind(&data_load_values, ctx, _1, &data_y)},
+    {"data-x-high", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-y-high", bind(&data_load_values, ctx, _1, &data_y)},
+    {"data-x-low", bind(&data_load_values, ctx, _1, &data_xoffset)},
+    {"data-y-low", bind(&data_load_values, ctx, _1, &data_yoffset)},
+    {"width", bind(&data_load, ctx, _1, &c->sizes)},
+    {"widths", bind(&data_load, ctx, _1, &c->sizes)},
+    {"offset", bind(&data_load, ctx, _1, &c->offsets)},
+    {"offsets", bind(&data_load, ctx, _1, &c->offsets)},
     {"stroke-color", bind(&color_read, ctx, _1, &c->stroke_style.color)},
     {"stroke-width", bind(&measure_read, _1, &c->stroke_style.line_width)},
     {"stroke-style", bind(&stroke_style_read, ctx, _1, &c->stroke_style)},
@@ -338,8 +348,8 @@ ReturnCode bars_draw(
     {"limit-y", bind(&expr_to_float64_opt_pair, _1, &c->scale_y.min, &c->scale_y.max)},
     {"limit-y-min", bind(&expr_to_float64_opt, _1, &c->scale_y.min)},
     {"limit-y-max", bind(&expr_to_float64_opt, _1, &c->scale_y.max)},
-    {"scale-x", bind(&scale_configure_kind, _1, &c->scale_x)},
-    {"scale-y", bind(&scale_configure_kind, _1, &c->scale_y)},
+    {"scale-x", bind(&scale_configure_kind, ctx, _1, &c->scale_x)},
+    {"scale-y", bind(&scale_configure_kind, ctx, _1, &c->scale_y)},
     {"scale-x-padding", bind(&expr_to_float64, _1, &c->scale_x.padding)},
     {"scale-y-padding", bind(&expr_to_float64, _1, &c->scale_y.padding)},
     {
@@ -356,7 +366,7 @@ ReturnCode bars_draw(
         { "vertical", Direction::VERTICAL },
       })
     },
-    {"labels", bind(&data_load_strings, _1, &c->labels)},
+    {"labels", bind(&data_load_strings, ctx, _1, &c->labels)},
     {"label-font-size", bind(&measure_read, _1, &c->label_font_size)},
     {"label-color", bind(&color_read, ctx, _1, &c->label_color)},
     {"label-padding", bind(&measure_read, _1, &c->label_padding)},
@@ -211,35 +211,35 @@ ReturnCode errorbars_draw(
   c->stroke_color = ctx->foreground_color;
 
   /* parse properties */
-  std::vector<std::string> data_x;
-  std::vector<std::string> data_x_low;
-  std::vector<std::string> data_x_high;
-  std::vector<std::string> data_y;
-  std::vector<std::string> data_y_low;
-  std::vector<std::string> data_y_high;
+  DataValues data_x;
+  DataValues data_x_low;
+  DataValues data_x_high;
+  DataValues data_y;
+  DataValues data_y_low;
+  DataValues data_y_high;
   std::vector<std::string> data_colors;
   ColorMap color_map;
 
   auto config_rc = expr_walk_map_with_defaults(expr_next(expr), ctx->defaults, {
-    {"data-x", bind(&data_load_strings, _1, &data_x)},
-    {"data-x-low", bind(&data_load_strings, _1, &data_x_low)},
-    {"data-x-high", bind(&data_load_strings, _1, &data_x_high)},
-    {"data-y", bind(&data_load_strings, _1, &data_y)},
-    {"data-y-low", bind(&data_load_strings, _1, &data_y_low)},
-    {"data-y-high", bind(&data_load_strings, _1, &data_y_high)},
+    {"data-x", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-x-low", bind(&data_load_values, ctx, _1, &data_x_low)},
+    {"data-x-high", bind(&data_load_values, ctx, _1, &data_x_high)},
+    {"data-y", bind(&data_load_values, ctx, _1, &data_y)},
+    {"data-y-low", bind(&data_load_values, ctx, _1, &data_y_low)},
+    {"data-y-high", bind(&data_load_values, ctx, _1, &data_y_high)},
     {"limit-x", bind(&expr_to_float64_opt_pair, _1, &c->scale_x.min, &c->scale_x.max)},
     {"limit-x-min", bind(&expr_to_float64_opt, _1, &c->scale_x.min)},
     {"limit-x-max", bind(&expr_to_float64_opt, _1, &c->scale_x.max)},
     {"limit-y", bind(&expr_to_float64_opt_pair, _1, &c->scale_y.min, &c->scale_y.max)},
     {"limit-y-min", bind(&expr_to_float64_opt, _1, &c->scale_y.min)},
     {"limit-y-max", bind(&expr_to_float64_opt, _1, &c->scale_y.max)},
-    {"scale-x", bind(&scale_configure_kind, _1, &c->scale_x)},
-    {"scale-y", bind(&scale_configure_kind, _1, &c->scale_y)},
+    {"scale-x", bind(&scale_configure_kind, ctx, _1, &c->scale_x)},
+    {"scale-y", bind(&scale_configure_kind, ctx, _1, &c->scale_y)},
     {"scale-x-padding", bind(&expr_to_float64, _1, &c->scale_x.padding)},
     {"scale-y-padding", bind(&expr_to_float64, _1, &c->scale_y.padding)},
     {"width", bind(&measure_read, _1, &c->bar_width)},
     {"color", bind(&color_read, ctx, _1, &c->stroke_color)},
-    {"colors", bind(&data_load_strings, _1, &data_colors)},
+    {"colors", bind(&data_load_strings, ctx, _1, &data_colors)},
     {"color-map", bind(&color_map_read, ctx, _1, &color_map)},
     {"stroke-color", bind(&color_read, ctx, _1, &c->stroke_color)},
     {"stroke-width", bind(&measure_read, _1, &c->stroke_width)}
@@ -251,14 +251,14 @@ ReturnCode errorbars_draw(
 
   /* figure out in which direction the user wants us to plot the error bars */
   std::optional<Direction> direction;
-  if (!data_x.empty() &&
-      !data_y_low.empty() &&
-      !data_y_high.empty() &&
-      data_y.empty()) {
+  if (data_x.size > 0 &&
+      data_y_low.size > 0 &&
+      data_y_high.size > 0 &&
+      data_y.size == 0) {
     direction = Direction::VERTICAL;
 
-    if (data_x.size() != data_y_low.size() ||
-        data_x.size() != data_y_high.size()) {
+    if (data_x.size != data_y_low.size ||
+        data_x.size != data_y_high.size) {
       return error(
           ERROR,
           "the length of the 'data-x', 'data-y-low' and 'data-y-high' datasets "
@@ -266,14 +266,14 @@ ReturnCode errorbars_draw(
     }
   }
 
-  if (!data_y.empty() &&
-      !data_x_low.empty() &&
-      !data_x_high.empty() &&
-      data_x.empty()) {
+  if (data_y.size > 0 &&
+      data_x_low.size > 0 &&
+      data_x_high.size > 0 &&
+      data_x.size == 0) {
     direction = Direction::HORIZONTAL;
 
-    if (data_y.size() != data_x_low.size() ||
-        data_y.size() != data_x_high.size()) {
+    if (data_y.size != data_x_low.size ||
+        data_y.size != data_x_high.size) {
       return error(
           ERROR,
           "the length of the 'data-x', 'data-y-low' and 'data-y-high' datasets "
@@ -101,8 +101,8 @@ ReturnCode draw_grid(Context* ctx, const Expr* expr) {
     {"limit-y-max", bind(&expr_to_float64_opt, _1, &c->scale_y.max)},
     {"tick-placement-x", bind(&scale_configure_layout, _1, &c->layout_x)},
     {"tick-placement-y", bind(&scale_configure_layout, _1, &c->layout_y)},
-    {"scale-x", bind(&scale_configure_kind, _1, &c->scale_x)},
-    {"scale-y", bind(&scale_configure_kind, _1, &c->scale_y)},
+    {"scale-x", bind(&scale_configure_kind, ctx, _1, &c->scale_x)},
+    {"scale-y", bind(&scale_configure_kind, ctx, _1, &c->scale_y)},
     {"scale-x-padding", bind(&expr_to_float64, _1, &c->scale_x.padding)},
     {"scale-y-padding", bind(&expr_to_float64, _1, &c->scale_y.padding)},
     {"color", bind(&color_read, ctx, _1, &c->stroke_style.color)},
@@ -128,9 +128,19 @@ ReturnCode draw_lines(
   }
 
   /* draw labels */
-  for (size_t i = 0; i < config->labels.size(); ++i) {
-    const auto& label_text = config->labels[i];
+  TextStyle label_style;
+  label_style.font = config->label_font;
+  label_style.color = config->label_color;
+  label_style.font_size = config->label_font_size;
+
+  std::vector<TextLayout> label_layouts;
+  if (auto rc =
+        text_layout_labels(ctx, config->labels, label_style, &label_layouts);
+      !rc) {
+    return rc;
+  }
 
+  for (size_t i = 0; i < config->labels.size(); ++i) {
     auto label_offset  = config->marker_size;
     auto label_padding = label_offset + measure_or(
         config->label_padding,
@@ -140,14 +150,9 @@ ReturnCode draw_lines(
         clip.x + config->x[i],
         clip.y + config->y[i] + label_padding);
 
-    TextStyle style;
-    style.font = config->label_font;
-    style.color = config->label_color;
-    style.font_size = config->label_font_size;
-
     auto ax = HAlign::CENTER;
     auto ay = VAlign::BOTTOM;
-    if (auto rc = draw_text(ctx, label_text, p, ax, ay, style); rc != OK) {
+    if (auto rc = draw_text(ctx, label_layouts[i], p, ax, ay, 0); !rc) {
       return rc;
     }
   }
@@ -168,20 +173,20 @@ ReturnCode draw_lines(
   c->marker_color = ctx->foreground_color;
 
   /* parse properties */
-  std::vector<std::string> data_x;
-  std::vector<std::string> data_y;
+  DataValues data_x;
+  DataValues data_y;
 
   auto config_rc = expr_walk_map_with_defaults(expr_next(expr), ctx->defaults, {
-    {"data-x", bind(&data_load_strings, _1, &data_x)},
-    {"data-y", bind(&data_load_strings, _1, &data_y)},
+    {"data-x", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-y", bind(&data_load_values, ctx, _1, &data_y)},
     {"limit-x", bind(&expr_to_float64_opt_pair, _1, &c->scale_x.min, &c->scale_x.max)},
     {"limit-x-min", bind(&expr_to_float64_opt, _1, &c->scale_x.min)},
     {"limit-x-max", bind(&expr_to_float64_opt, _1, &c->scale_x.max)},
     {"limit-y", bind(&expr_to_float64_opt_pair, _1, &c->scale_y.min, &c->scale_y.max)},
     {"limit-y-min", bind(&expr_to_float64_opt, _1, &c->scale_y.min)},
     {"limit-y-max", bind(&expr_to_float64_opt, _1, &c->scale_y.max)},
-    {"scale-x", bind(&scale_configure_kind, _1, &c->scale_x)},
-    {"scale-y", bind(&scale_configure_kind, _1, &c->scale_y)},
+    {"scale-x", bind(&scale_configure_kind, ctx, _1, &c->scale_x)},
+    {"scale-y", bind(&scale_configure_kind, ctx, _1, &c->scale_y)},
     {"scale-x-padding", bind(&expr_to_float64, _1, &c->scale_x.padding)},
     {"scale-y-padding", bind(&expr_to_float64, _1, &c->scale_y.padding)},
     {
@@ -197,7 +202,7 @@ ReturnCode draw_lines(
     {"marker-size", bind(&measure_read, _1, &c->marker_size)},
     {"marker-shape", bind(&marker_configure, _1, &c->marker_shape)},
     {"marker-color", bind(&color_read, ctx, _1, &c->marker_color)},
-    {"labels", bind(&data_load_strings, _1, &c->labels)},
+    {"labels", bind(&data_load_strings, ctx, _1, &c->labels)},
     {"label-font-size", bind(&measure_read, _1, &c->label_font_size)},
     {"label-color", bind(&color_read, ctx, _1, &c->label_color)},
     {"label-padding", bind(&measure_read, _1, &c->label_padding)},
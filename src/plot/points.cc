@@ -115,9 +115,19 @@ ReturnCode points_draw(
   }
 
   /* draw labels */
-  for (size_t i = 0; i < config->labels.size(); ++i) {
-    const auto& label_text = config->labels[i];
+  TextStyle label_style;
+  label_style.font = config->label_font;
+  label_style.color = config->label_color;
+  label_style.font_size = config->label_font_size;
+
+  std::vector<TextLayout> label_layouts;
+  if (auto rc =
+        text_layout_labels(ctx, config->labels, label_style, &label_layouts);
+      !rc) {
+    return rc;
+  }
 
+  for (size_t i = 0; i < config->labels.size(); ++i) {
     auto size = config->sizes.empty()
         ? 0
         : config->sizes[i % config->sizes.size()].value;
@@ -130,14 +140,9 @@ ReturnCode points_draw(
         clip.x + config->x[i],
         clip.y + config->y[i] + label_padding);
 
-    TextStyle style;
-    style.font = config->label_font;
-    style.color = config->label_color;
-    style.font_size = config->label_font_size;
-
     auto ax = HAlign::CENTER;
     auto ay = VAlign::BOTTOM;
-    if (auto rc = draw_text(ctx, label_text, p, ax, ay, style); rc != OK) {
+    if (auto rc = draw_text(ctx, label_layouts[i], p, ax, ay, 0); !rc) {
       return rc;
     }
   }
@@ -157,35 +162,35 @@ ReturnCode points_draw(
   c->label_font_size = ctx->font_size;
 
   /* parse properties */
-  std::vector<std::string> data_x;
-  std::vector<std::string> data_y;
+  DataValues data_x;
+  DataValues data_y;
   std::vector<std::string> data_colors;
   std::vector<std::string> data_sizes;
   ColorMap color_map;
   MeasureMap size_map;
 
   auto config_rc = expr_walk_map_with_defaults(expr_next(expr), ctx->defaults, {
-    {"data-x", bind(&data_load_strings, _1, &data_x)},
-    {"data-y", bind(&data_load_strings, _1, &data_y)},
+    {"data-x", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-y", bind(&data_load_values, ctx, _1, &data_y)},
     {"limit-x", bind(&expr_to_float64_opt_pair, _1, &c->scale_x.min, &c->scale_x.max)},
     {"limit-x-min", bind(&expr_to_float64_opt, _1, &c->scale_x.min)},
     {"limit-x-max", bind(&expr_to_float64_opt, _1, &c->scale_x.max)},
     {"limit-y", bind(&expr_to_float64_opt_pair, _1, &c->scale_y.min, &c->scale_y.max)},
     {"limit-y-min", bind(&expr_to_float64_opt, _1, &c->scale_y.min)},
     {"limit-y-max", bind(&expr_to_float64_opt, _1, &c->scale_y.max)},
-    {"scale-x", bind(&scale_configure_kind, _1, &c->scale_x)},
-    {"scale-y", bind(&scale_configure_kind, _1, &c->scale_y)},
+    {"scale-x", bind(&scale_configure_kind, ctx, _1, &c->scale_x)},
+    {"scale-y", bind(&scale_configure_kind, ctx, _1, &c->scale_y)},
     {"scale-x-padding", bind(&expr_to_float64, _1, &c->scale_x.padding)},
     {"scale-y-padding", bind(&expr_to_float64, _1, &c->scale_y.padding)},
     {"shape", bind(&marker_configure, _1, &c->shape)},
     {"shapes", bind(&marker_configure_list, _1, &c->shapes)},
     {"size", bind(&measure_read, _1, &c->size)},
-    {"sizes", bind(&data_load_strings, _1, &data_sizes)},
+    {"sizes", bind(&data_load_strings, ctx, _1, &data_sizes)},
     {"size-map", bind(&measure_map_read, ctx, _1, &size_map)},
     {"color", bind(&color_read, ctx, _1, &c->color)},
-    {"colors", bind(&data_load_strings, _1, &data_colors)},
+    {"colors", bind(&data_load_strings, ctx, _1, &data_colors)},
     {"color-map", bind(&color_map_read, ctx, _1, &color_map)},
-    {"labels", bind(&data_load_strings, _1, &c->labels)},
+    {"labels", bind(&data_load_strings, ctx, _1, &c->labels)},
     {"label-font", expr_call_string_fn(bind(&font_load_best, _1, &c->label_font))},
     {"label-font-size", bind(&measure_read, _1, &c->label_font_size)},
     {"label-color", bind(&color_read, ctx, _1, &c->label_color)},
@@ -146,24 +146,24 @@ ReturnCode rectangles_draw(
   c->size = from_pt(kDefaultPointSizePT);
 
   /* parse properties */
-  std::vector<std::string> data_x;
-  std::vector<std::string> data_y;
+  DataValues data_x;
+  DataValues data_y;
   std::vector<std::string> data_colors;
-  std::vector<std::string> data_size_x;
-  std::vector<std::string> data_size_y;
+  DataValues data_size_x;
+  DataValues data_size_y;
   ColorMap color_map;
 
   auto config_rc = expr_walk_map_with_defaults(expr_next(expr), ctx->defaults, {
-    {"data-x", bind(&data_load_strings, _1, &data_x)},
-    {"data-y", bind(&data_load_strings, _1, &data_y)},
+    {"data-x", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-y", bind(&data_load_values, ctx, _1, &data_y)},
     {"limit-x", bind(&expr_to_float64_opt_pair, _1, &c->scale_x.min, &c->scale_x.max)},
     {"limit-x-min", bind(&expr_to_float64_opt, _1, &c->scale_x.min)},
     {"limit-x-max", bind(&expr_to_float64_opt, _1, &c->scale_x.max)},
     {"limit-y", bind(&expr_to_float64_opt_pair, _1, &c->scale_y.min, &c->scale_y.max)},
     {"limit-y-min", bind(&expr_to_float64_opt, _1, &c->scale_y.min)},
     {"limit-y-max", bind(&expr_to_float64_opt, _1, &c->scale_y.max)},
-    {"scale-x", bind(&scale_configure_kind, _1, &c->scale_x)},
-    {"scale-y", bind(&scale_configure_kind, _1, &c->scale_y)},
+    {"scale-x", bind(&scale_configure_kind, ctx, _1, &c->scale_x)},
+    {"scale-y", bind(&scale_configure_kind, ctx, _1, &c->scale_y)},
     {"scale-x-padding", bind(&expr_to_float64, _1, &c->scale_x.padding)},
     {"scale-y-padding", bind(&expr_to_float64, _1, &c->scale_y.padding)},
     {
@@ -178,14 +178,14 @@ ReturnCode rectangles_draw(
     {
       "sizes",
       expr_calln_fn({
-        bind(&data_load_strings, _1, &data_size_x),
-        bind(&data_load_strings, _1, &data_size_y),
+        bind(&data_load_values, ctx, _1, &data_size_x),
+        bind(&data_load_values, ctx, _1, &data_size_y),
       })
     },
-    {"sizes-x", bind(&data_load_strings, _1, &data_size_x)},
-    {"sizes-y", bind(&data_load_strings, _1, &data_size_y)},
+    {"sizes-x", bind(&data_load_values, ctx, _1, &data_size_x)},
+    {"sizes-y", bind(&data_load_values, ctx, _1, &data_size_y)},
     {"color", bind(&color_read, ctx, _1, &c->color)},
-    {"colors", bind(&data_load_strings, _1, &data_colors)},
+    {"colors", bind(&data_load_strings, ctx, _1, &data_colors)},
     {"color-map", bind(&color_map_read, ctx, _1, &color_map)},
   });
 
@@ -150,35 +150,35 @@ ReturnCode vectors_draw(
   c->label_font_size = ctx->font_size;
 
   /* parse properties */
-  std::vector<std::string> data_x;
-  std::vector<std::string> data_y;
-  std::vector<std::string> data_dx;
-  std::vector<std::string> data_dy;
+  DataValues data_x;
+  DataValues data_y;
+  DataValues data_dx;
+  DataValues data_dy;
   std::vector<std::string> data_colors;
   std::vector<std::string> data_sizes;
   ColorMap color_map;
   MeasureMap size_map;
 
   auto config_rc = expr_walk_map_with_defaults(expr_next(expr), ctx->defaults, {
-    {"data-x", bind(&data_load_strings, _1, &data_x)},
-    {"data-y", bind(&data_load_strings, _1, &data_y)},
-    {"data-dx", bind(&data_load_strings, _1, &data_dx)},
-    {"data-dy", bind(&data_load_strings, _1, &data_dy)},
+    {"data-x", bind(&data_load_values, ctx, _1, &data_x)},
+    {"data-y", bind(&data_load_values, ctx, _1, &data_y)},
+    {"data-dx", bind(&data_load_values, ctx, _1, &data_dx)},
+    {"data-dy", bind(&data_load_values, ctx, _1, &data_dy)},
     {"limit-x", bind(&expr_to_float64_opt_pair, _1, &c->scale_x.min, &c->scale_x.max)},
     {"limit-x-min", bind(&expr_to_float64_opt, _1, &c->scale_x.min)},
     {"limit-x-max", bind(&expr_to_float64_opt, _1, &c->scale_x.max)},
     {"limit-y", bind(&expr_to_float64_opt_pair, _1, &c->scale_y.min, &c->scale_y.max)},
     {"limit-y-min", bind(&expr_to_float64_opt, _1, &c->scale_y.min)},
     {"limit-y-max", bind(&expr_to_float64_opt, _1, &c->scale_y.max)},
-    {"scale-x", bind(&scale_configure_kind, _1, &c->scale_x)},
-    {"scale-y", bind(&scale_configure_kind, _1, &c->scale_y)},
+    {"scale-x", bind(&scale_configure_kind, ctx, _1, &c->scale_x)},
+    {"scale-y", bind(&scale_configure_kind, ctx, _1, &c->scale_y)},
     {"scale-x-padding", bind(&expr_to_float64, _1, &c->scale_x.padding)},
     {"scale-y-padding", bind(&expr_to_float64, _1, &c->scale_y.padding)},
     {"color", bind(&color_read, ctx, _1, &c->color)},
-    {"colors", bind(&data_load_strings, _1, &data_colors)},
+    {"colors", bind(&data_load_strings, ctx, _1, &data_colors)},
     {"color-map", bind(&color_map_read, ctx, _1, &color_map)},
     {"size", bind(&measure_read, _1, &c->size)},
-    {"sizes", bind(&data_load_strings, _1, &data_sizes)},
+    {"sizes", bind(&data_load_strings, ctx, _1, &data_sizes)},
     {"size-map", bind(&measure_map_read, ctx, _1, &size_map)},
   });
 
@@ -210,6 +210,7 @@ std::vector<double> scale_untranslate(
 }
 
 ReturnCode scale_configure_kind(
+    const Context* ctx,
     const Expr* expr,
     ScaleConfig* domain) {
   if (expr && expr_is_list(expr)) {
@@ -253,7 +254,7 @@ ReturnCode scale_configure_kind(
       domain->padding = 0.5;
 
       expr = expr_next(expr);
-      if (auto rc = data_load_strings(expr, &domain->categories); !rc) {
+      if (auto rc = data_load_strings(ctx, expr, &domain->categories); !rc) {
         return rc;
       }
 
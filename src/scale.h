@@ -24,6 +24,7 @@
 #include "format.h"
 
 namespace clip {
+struct Context;
 
 enum class ScaleKind {
   LINEAR, LOGARITHMIC, CATEGORICAL
@@ -88,6 +89,7 @@ std::vector<double> scale_untranslate(
     const std::vector<double>& data);
 
 ReturnCode scale_configure_kind(
+    const Context* ctx,
     const Expr* expr,
     ScaleConfig* domain);
 
@@ -0,0 +1,415 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "server.h"
+#include "eval.h"
+#include "graphics/font_lookup.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace clip {
+
+static const size_t kServerMaxRequestSize = 64 * 1024 * 1024;
+static const uint32_t kServerAcceptBackoffMinMS = 10;
+static const uint32_t kServerAcceptBackoffMaxMS = 1000;
+
+using ProgramRef = std::shared_ptr<const Program>;
+
+struct ServerProgramCache {
+  std::mutex lock;
+  std::unordered_map<std::string, ProgramRef> programs;
+  std::unordered_map<std::string, ProgramRef> templates;
+  size_t capacity;
+};
+
+struct ServerQueue {
+  std::mutex lock;
+  std::condition_variable wakeup;
+  std::deque<int> connections;
+  bool shutdown = false;
+};
+
+struct ServerRequest {
+  OutputFormat format;
+  ProgramParams params;
+  std::string script;
+};
+
+ServerConfig::ServerConfig() :
+    worker_count(std::max(std::thread::hardware_concurrency(), 1u)),
+    program_cache_size(1024),
+    font_defaults(true) {}
+
+ReturnCode server_read(int fd, std::string* data) {
+  char buf[65536];
+
+  for (;;) {
+    auto rc = ::read(fd, buf, sizeof(buf));
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (rc < 0) {
+      return errorf(ERROR, "read() failed: {}", strerror(errno));
+    }
+
+    if (rc == 0) {
+      return OK;
+    }
+
+    data->append(buf, rc);
+    if (data->size() > kServerMaxRequestSize) {
+      return error(ERROR, "request too large");
+    }
+  }
+}
+
+ReturnCode server_write(int fd, const std::string& data) {
+  size_t pos = 0;
+
+  while (pos < data.size()) {
+    auto rc = ::write(fd, data.data() + pos, data.size() - pos);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (rc < 0) {
+      return errorf(ERROR, "write() failed: {}", strerror(errno));
+    }
+
+    pos += rc;
+  }
+
+  return OK;
+}
+
+ReturnCode server_parse_request(
+    const std::string& data,
+    ServerRequest* request) {
+  auto header_end = data.find("\n\n");
+  if (header_end == std::string::npos) {
+    return error(ERROR, "invalid request: missing header terminator");
+  }
+
+  request->format = OutputFormat::SVG;
+  request->script = data.substr(header_end + 2);
+
+  size_t line_begin = 0;
+  while (line_begin < header_end) {
+    auto line_end = data.find('\n', line_begin);
+    if (line_end == std::string::npos || line_end > header_end) {
+      line_end = header_end;
+    }
+
+    auto line = data.substr(line_begin, line_end - line_begin);
+    line_begin = line_end + 1;
+
+    if (line.empty()) {
+      continue;
+    }
+
+    auto sep = line.find(' ');
+    auto key = line.substr(0, sep);
+    auto value = sep == std::string::npos ? "" : line.substr(sep + 1);
+
+    if (key == "format") {
+      if (value == "svg") {
+        request->format = OutputFormat::SVG;
+      } else if (value == "png") {
+        request->format = OutputFormat::PNG;
+      } else {
+        return errorf(ERROR, "invalid output format: {}", value);
+      }
+
+      continue;
+    }
+
+    if (key == "param") {
+      if (auto rc = program_bind_param(value, &request->params); !rc) {
+        return rc;
+      }
+
+      continue;
+    }
+
+    return errorf(ERROR, "invalid request header: {}", key);
+  }
+
+  return OK;
+}
+
+ReturnCode server_get_program(
+    ServerProgramCache* cache,
+    const std::string& script,
+    bool templated,
+    ProgramRef* program) {
+  auto& programs = templated ? cache->templates : cache->programs;
+
+  {
+    std::lock_guard<std::mutex> lk(cache->lock);
+    auto iter = programs.find(script);
+    if (iter != programs.end()) {
+      *program = iter->second;
+      return OK;
+    }
+  }
+
+  // compile outside of the lock so that other workers are not blocked
+  auto program_new = std::make_shared<Program>();
+  auto rc = templated ?
+      program_compile_template(script, program_new.get()) :
+      program_compile(script, program_new.get());
+
+  if (!rc) {
+    return rc;
+  }
+
+  std::lock_guard<std::mutex> lk(cache->lock);
+  if (cache->programs.size() + cache->templates.size() >= cache->capacity) {
+    cache->programs.clear();
+    cache->templates.clear();
+  }
+
+  programs.emplace(script, program_new);
+  *program = program_new;
+  return OK;
+}
+
+ReturnCode server_render(
+    const FontInfo& font,
+    ServerProgramCache* cache,
+    const std::string& data,
+    std::string* output) {
+  ServerRequest request;
+  if (auto rc = server_parse_request(data, &request); !rc) {
+    return rc;
+  }
+
+  // requests with parameters are rendered from a template
+  ProgramRef program;
+  auto program_rc = server_get_program(
+      cache,
+      request.script,
+      !request.params.empty(),
+      &program);
+
+  if (!program_rc) {
+    return program_rc;
+  }
+
+  Context ctx;
+  ctx.font = font;
+
+  if (auto rc = eval(&ctx, *program, request.params); !rc) {
+    return rc;
+  }
+
+  return eval_export(&ctx, request.format, output);
+}
+
+void server_handle(
+    int fd,
+    const FontInfo& font,
+    ServerProgramCache* cache) {
+  std::string request;
+  std::string output;
+
+  auto rc = server_read(fd, &request);
+  if (rc) {
+    rc = server_render(font, cache, request, &output);
+  }
+
+  std::string response;
+  if (rc) {
+    response = fmt::format("OK {}\n", output.size());
+    response += output;
+  } else {
+    response = fmt::format("ERROR {}\n", rc.message);
+  }
+
+  server_write(fd, response);
+  close(fd);
+}
+
+void server_work(
+    const FontInfo* font,
+    ServerQueue* queue,
+    ServerProgramCache* cache) {
+  for (;;) {
+    int fd;
+
+    {
+      std::unique_lock<std::mutex> lk(queue->lock);
+      queue->wakeup.wait(lk, [queue] {
+        return queue->shutdown || !queue->connections.empty();
+      });
+
+      // queued connections are still served when the server shuts down
+      if (queue->connections.empty()) {
+        return;
+      }
+
+      fd = queue->connections.front();
+      queue->connections.pop_front();
+    }
+
+    server_handle(fd, *font, cache);
+  }
+}
+
+ReturnCode server_listen(const std::string& path, int* fd) {
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return errorf(ERROR, "socket path too long: {}", path);
+  }
+
+  memcpy(addr.sun_path, path.data(), path.size());
+
+  *fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (*fd < 0) {
+    return errorf(ERROR, "socket() failed: {}", strerror(errno));
+  }
+
+  // remove a stale socket from a previous run
+  unlink(path.c_str());
+
+  if (bind(*fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
+    close(*fd);
+    return errorf(ERROR, "bind() failed: {}: {}", path, strerror(errno));
+  }
+
+  if (listen(*fd, SOMAXCONN) < 0) {
+    close(*fd);
+    return errorf(ERROR, "listen() failed: {}", strerror(errno));
+  }
+
+  return OK;
+}
+
+ReturnCode server_run(const ServerConfig& config) {
+  if (config.worker_count == 0) {
+    return error(ERROR, "the worker count must be at least one");
+  }
+
+  // the fonts are loaded once and shared by all workers
+  FontInfo font;
+  {
+    Context ctx;
+    ctx.font_defaults = config.font_defaults;
+    ctx.font_load = config.font_load;
+
+    if (auto rc = context_setup_defaults(&ctx); !rc) {
+      return rc;
+    }
+
+    font = ctx.font;
+  }
+
+  // fonts are never released, so requests may only use the fonts that were
+  // loaded on startup
+  font_load_disable();
+
+  int listen_fd;
+  if (auto rc = server_listen(config.socket_path, &listen_fd); !rc) {
+    return rc;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+
+  ServerQueue queue;
+  ServerProgramCache cache;
+  cache.capacity = std::max(config.program_cache_size, size_t(1));
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < config.worker_count; ++i) {
+    workers.emplace_back(&server_work, &font, &queue, &cache);
+  }
+
+  ReturnCode rc = OK;
+  uint32_t backoff_ms = 0;
+  for (;;) {
+    auto fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0 && (errno == EINTR || errno == ECONNABORTED)) {
+      continue;
+    }
+
+    // running out of file descriptors or memory is usually temporary, so
+    // wait for connections to close instead of retrying immediately
+    if (fd < 0 && (
+          errno == EMFILE ||
+          errno == ENFILE ||
+          errno == ENOBUFS ||
+          errno == ENOMEM)) {
+      backoff_ms = std::clamp(
+          backoff_ms * 2,
+          kServerAcceptBackoffMinMS,
+          kServerAcceptBackoffMaxMS);
+
+      auto err = errorf(
+          ERROR,
+          "accept() failed: {}; retrying in {}ms",
+          strerror(errno),
+          backoff_ms);
+
+      error_print(err, std::cerr);
+      std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+      continue;
+    }
+
+    if (fd < 0) {
+      rc = errorf(ERROR, "accept() failed: {}", strerror(errno));
+      break;
+    }
+
+    backoff_ms = 0;
+
+    {
+      std::lock_guard<std::mutex> lk(queue.lock);
+      queue.connections.push_back(fd);
+    }
+
+    queue.wakeup.notify_one();
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(queue.lock);
+    queue.shutdown = true;
+  }
+
+  queue.wakeup.notify_all();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  close(listen_fd);
+  return rc;
+}
+
+} // namespace clip
+
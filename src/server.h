@@ -0,0 +1,57 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include "return_code.h"
+
+namespace clip {
+
+struct ServerConfig {
+  ServerConfig();
+
+  std::string socket_path;
+  size_t worker_count;
+  size_t program_cache_size;
+
+  bool font_defaults;
+  std::vector<std::string> font_load;
+};
+
+/**
+ * Run the render server. The server listens on a unix domain socket and
+ * renders one chart per connection. The fonts are loaded once on startup and
+ * shared by all workers; compiled programs are cached and shared as well.
+ *
+ * Fonts are never released (see font_stack_intern), so loading fonts is
+ * disabled once the server has started and requests that load a font, e.g.
+ * using `font` or `label-font`, fail. All fonts must be loaded on startup using
+ * `font_load`. The compiled program cache is bounded by `program_cache_size`.
+ *
+ * A request consists of a list of header lines, followed by an empty line and
+ * the input script. The client must shut down the sending side of the
+ * connection after writing the script. Supported headers are:
+ *
+ *   format <svg|png>
+ *   param <name>=<value>
+ *
+ * The response is either `OK <length>\n` followed by the output bytes or
+ * `ERROR <message>\n`.
+ *
+ * This function only returns if the server could not be started.
+ */
+ReturnCode server_run(const ServerConfig& config);
+
+} // namespace clip
+
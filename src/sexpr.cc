@@ -132,6 +132,10 @@ const std::string& expr_get_value(const Expr* expr) {
   return expr->value;
 }
 
+void expr_set_value(Expr* expr, const std::string& value) {
+  expr->value = value;
+}
+
 ExprStorage expr_clone(const Expr* e, int count /* =-1 */) {
   ExprStorage copy;
   ExprStorage* c = &copy;
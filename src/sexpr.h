@@ -44,6 +44,7 @@ bool expr_is_value_literal(const Expr* expr, const std::string& cmp);
 bool expr_is_value_quoted(const Expr* expr);
 bool expr_is_value_quoted(const Expr* expr, const std::string& cmp);
 const std::string& expr_get_value(const Expr* expr);
+void expr_set_value(Expr* expr, const std::string& value);
 
 ExprStorage expr_clone(const Expr* e, int count=-1);
 
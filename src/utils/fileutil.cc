@@ -228,4 +228,26 @@ ReturnCode read_file(const std::string& path, std::string* data) {
   return OK;
 }
 
+ReturnCode write_file(const std::string& path, const std::string& data) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return errorf(
+        ERROR,
+        "error while writing file: '{}': {}",
+        path,
+        strerror(errno));
+  }
+
+  file.write(data.data(), data.size());
+  if (!file) {
+    return errorf(
+        ERROR,
+        "error while writing file: '{}': {}",
+        path,
+        strerror(errno));
+  }
+
+  return OK;
+}
+
 }
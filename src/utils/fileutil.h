@@ -98,5 +98,7 @@ public:
 
 ReturnCode read_file(const std::string& path, std::string* data);
 
+ReturnCode write_file(const std::string& path, const std::string& data);
+
 }
 #endif
@@ -401,6 +401,40 @@ std::string StringUtil::hexPrint(
   return BufferUtil::hexPrint(&buf, sep, reverse);
 }
 
+std::string StringUtil::base64Encode(const void* data, size_t size) {
+  static const char alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  auto bytes = static_cast<const unsigned char*>(data);
+
+  std::string out;
+  out.reserve((size + 2) / 3 * 4);
+
+  size_t i = 0;
+  for (; i + 2 < size; i += 3) {
+    uint32_t v = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+    out += alphabet[(v >> 18) & 0x3f];
+    out += alphabet[(v >> 12) & 0x3f];
+    out += alphabet[(v >> 6) & 0x3f];
+    out += alphabet[v & 0x3f];
+  }
+
+  if (i + 1 == size) {
+    uint32_t v = bytes[i] << 16;
+    out += alphabet[(v >> 18) & 0x3f];
+    out += alphabet[(v >> 12) & 0x3f];
+    out += "==";
+  } else if (i + 2 == size) {
+    uint32_t v = (bytes[i] << 16) | (bytes[i + 1] << 8);
+    out += alphabet[(v >> 18) & 0x3f];
+    out += alphabet[(v >> 12) & 0x3f];
+    out += alphabet[(v >> 6) & 0x3f];
+    out += '=';
+  }
+
+  return out;
+}
+
 std::basic_string<char32_t> StringUtil::convertUTF8To32(
     const std::basic_string<char>& str) {
   std::basic_string<char32_t> out;
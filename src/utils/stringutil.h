@@ -266,6 +266,19 @@ public:
       bool separate_bytes = true,
       bool reverse_byte_order = false);
 
+  /**
+   * Encode the pointed to memory using base64 (RFC 4648) with padding
+   *
+   * Example:
+   *   StringUtil::base64Encode("clip", 4);
+   *   // returns "Y2xpcA=="
+   *
+   * @param data the data to encode
+   * @param size the size of the data in bytes
+   * @return the base64 encoded data
+   */
+  static std::string base64Encode(const void* data, size_t size);
+
   /**
    * Format the provided string using fmt::format and print to stdou
    *
@@ -0,0 +1,259 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "watch.h"
+#include "data.h"
+#include "utils/fileutil.h"
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace clip {
+
+#if defined(__linux__)
+
+static const int kWatchSettleMillis = 50;
+
+struct WatchState {
+  int inotify_fd;
+  std::map<std::string, int> dirs;
+  std::map<int, std::string> dirs_by_wd;
+  std::map<std::pair<std::string, std::string>, std::string> files;
+};
+
+void watch_split_path(
+    const std::string& path,
+    std::string* dir,
+    std::string* name) {
+  auto sep = path.rfind('/');
+  if (sep == std::string::npos) {
+    *dir = ".";
+    *name = path;
+  } else {
+    *dir = sep == 0 ? "/" : path.substr(0, sep);
+    *name = path.substr(sep + 1);
+  }
+}
+
+ReturnCode watch_add(WatchState* state, const std::string& path) {
+  std::string dir;
+  std::string name;
+  watch_split_path(path, &dir, &name);
+
+  // editors often replace files instead of writing them in place, so the
+  // parent directory is watched instead of the file itself
+  if (!state->dirs.count(dir)) {
+    auto wd = inotify_add_watch(
+        state->inotify_fd,
+        dir.c_str(),
+        IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+    if (wd < 0) {
+      return errorf(
+          ERROR,
+          "unable to watch directory '{}': {}",
+          dir,
+          strerror(errno));
+    }
+
+    state->dirs[dir] = wd;
+    state->dirs_by_wd[wd] = dir;
+  }
+
+  state->files[std::make_pair(dir, name)] = path;
+  return OK;
+}
+
+ReturnCode watch_read_events(
+    WatchState* state,
+    std::set<std::string>* changed) {
+  alignas(struct inotify_event) char buf[65536];
+
+  auto len = read(state->inotify_fd, buf, sizeof(buf));
+  if (len < 0) {
+    if (errno == EINTR || errno == EAGAIN) {
+      return OK;
+    }
+
+    return errorf(ERROR, "read() failed: {}", strerror(errno));
+  }
+
+  for (ssize_t pos = 0; pos < len; ) {
+    auto ev = reinterpret_cast<const struct inotify_event*>(buf + pos);
+    pos += sizeof(struct inotify_event) + ev->len;
+
+    auto dir = state->dirs_by_wd.find(ev->wd);
+    if (dir == state->dirs_by_wd.end() || ev->len == 0) {
+      continue;
+    }
+
+    auto file = state->files.find(std::make_pair(dir->second, ev->name));
+    if (file != state->files.end()) {
+      changed->insert(file->second);
+    }
+  }
+
+  return OK;
+}
+
+ReturnCode watch_wait(WatchState* state, std::set<std::string>* changed) {
+  while (changed->empty()) {
+    if (auto rc = watch_read_events(state, changed); !rc) {
+      return rc;
+    }
+  }
+
+  // a single save often triggers several events; wait until the files have
+  // settled so that they are only rendered once
+  for (;;) {
+    struct pollfd p;
+    p.fd = state->inotify_fd;
+    p.events = POLLIN;
+
+    auto rc = poll(&p, 1, kWatchSettleMillis);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (rc <= 0) {
+      return OK;
+    }
+
+    if (auto rc = watch_read_events(state, changed); !rc) {
+      return rc;
+    }
+  }
+}
+
+ReturnCode watch_render(
+    const WatchConfig& config,
+    const FontInfo& font,
+    const Program& program,
+    const std::shared_ptr<DataCache>& data_cache) {
+  Context ctx;
+  ctx.font = font;
+  ctx.data_cache = data_cache;
+
+  if (auto rc = eval(&ctx, program, config.params); !rc) {
+    return rc;
+  }
+
+  std::string output;
+  if (auto rc = eval_export(&ctx, config.output_format, &output); !rc) {
+    return rc;
+  }
+
+  return write_file(config.output_path, output);
+}
+
+ReturnCode watch_run(const WatchConfig& config) {
+  FontInfo font;
+  {
+    Context ctx;
+    ctx.font_defaults = config.font_defaults;
+    ctx.font_load = config.font_load;
+
+    if (auto rc = context_setup_defaults(&ctx); !rc) {
+      return rc;
+    }
+
+    font = ctx.font;
+  }
+
+  WatchState state;
+  state.inotify_fd = inotify_init1(IN_CLOEXEC);
+  if (state.inotify_fd < 0) {
+    return errorf(ERROR, "inotify_init1() failed: {}", strerror(errno));
+  }
+
+  auto data_cache = std::make_shared<DataCache>();
+  std::unique_ptr<Program> program;
+  std::set<std::string> changed = {config.input_path};
+
+  for (;;) {
+    for (const auto& path : changed) {
+      if (path != config.input_path) {
+        data_cache_invalidate(data_cache.get(), path);
+      }
+    }
+
+    if (changed.count(config.input_path)) {
+      program.reset();
+    }
+
+    changed.clear();
+
+    ReturnCode rc;
+    if (!program) {
+      std::string input;
+      rc = read_file(config.input_path, &input);
+
+      if (rc) {
+        program = std::make_unique<Program>();
+        rc = config.templated ?
+            program_compile_template(input, program.get()) :
+            program_compile(input, program.get());
+      }
+
+      if (!rc) {
+        program.reset();
+      }
+    }
+
+    if (rc) {
+      rc = watch_render(config, font, *program, data_cache);
+    }
+
+    if (rc) {
+      std::cerr << "Rendered " << config.output_path << std::endl;
+    } else {
+      error_print(rc, std::cerr);
+    }
+
+    if (auto rc = watch_add(&state, config.input_path); !rc) {
+      return rc;
+    }
+
+    // a data file that can not be watched is reported, but the input file is
+    // still watched so that the reference can be fixed
+    for (const auto& path : data_cache_list(data_cache.get())) {
+      if (auto rc = watch_add(&state, path); !rc) {
+        error_print(rc, std::cerr);
+      }
+    }
+
+    if (auto rc = watch_wait(&state, &changed); !rc) {
+      return rc;
+    }
+  }
+}
+
+#else
+
+ReturnCode watch_run(const WatchConfig& config) {
+  return error(ERROR, "watch mode is only supported on linux");
+}
+
+#endif
+
+} // namespace clip
+
@@ -0,0 +1,48 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include "eval.h"
+#include "return_code.h"
+
+namespace clip {
+
+struct WatchConfig {
+  std::string input_path;
+  std::string output_path;
+  OutputFormat output_format;
+  bool templated;
+  ProgramParams params;
+
+  bool font_defaults;
+  std::vector<std::string> font_load;
+};
+
+/**
+ * Render the input file and re-render it whenever the input file or one of the
+ * data files it references changes. The fonts are loaded once, the input file
+ * is only re-compiled when it changes and data files are only re-parsed when
+ * they change. Errors during rendering are reported but do not stop watching.
+ *
+ * Fonts are never released (see font_stack_intern), so each distinct font or
+ * font combination that an edit of the input file loads stays in memory until
+ * watching stops. Fonts that are loaded again are shared with earlier renders.
+ *
+ * This function only returns if watching the files failed.
+ */
+ReturnCode watch_run(const WatchConfig& config);
+
+} // namespace clip
+
@@ -52,6 +52,7 @@ run_test() {
 	local infile="${test_path}/${test_id}.clp"
 	local reffile="${test_path}/${test_id}.${format}"
 	local errfile="${test_path}/${test_id}.err"
+	local paramfile="${test_path}/${test_id}.param"
 	local outfile="${result_path}/${test_id}.${format}"
 	local logfile="${result_path}/${test_id}.log"
 
@@ -59,11 +60,19 @@ run_test() {
 	rm -rf "${outfile}" "${logfile}"
 	mkdir -p "$(dirname "${outfile}")"
 
-	# run clip
+	# run clip; test cases with a parameter file are rendered as a template
+	local input_args=(--in "${infile}")
+	if [[ -e "${paramfile}" ]]; then
+		input_args=(--template "${infile}")
+		while read -r param; do
+			input_args+=(--param "${param}")
+		done < "${paramfile}"
+	fi
+
 	result=""
 	if (cd ${source_path} && "${proc_path}" \
 				--font-load "test/testdata/fonts/LiberationSans-Regular.ttf" \
-				--in "${infile}" \
+				"${input_args[@]}" \
 				--out "${outfile}" \
 				2> "${logfile}"); then
 		result="ok"
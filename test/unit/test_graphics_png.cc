@@ -0,0 +1,161 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <png.h>
+#include <iostream>
+#include "context.h"
+#include "graphics/draw.h"
+#include "graphics/export_image.h"
+#include "graphics/png.h"
+#include "unittest.h"
+
+using namespace clip;
+
+uint32_t read_uint32_be(const std::string& data, size_t offset) {
+  return
+      (uint32_t(uint8_t(data[offset + 0])) << 24) |
+      (uint32_t(uint8_t(data[offset + 1])) << 16) |
+      (uint32_t(uint8_t(data[offset + 2])) << 8) |
+      (uint32_t(uint8_t(data[offset + 3])));
+}
+
+ReturnCode write_png(
+    const std::vector<uint32_t>& pixels,
+    uint32_t width,
+    uint32_t height,
+    std::string* out) {
+  return png_write_argb32(
+      reinterpret_cast<const unsigned char*>(pixels.data()),
+      width,
+      height,
+      width * sizeof(uint32_t),
+      [out] (const char* data, size_t size) -> ReturnCode {
+        out->append(data, size);
+        return OK;
+      });
+}
+
+void test_png_header() {
+  std::vector<uint32_t> pixels(7 * 3, 0xff000000);
+
+  std::string png;
+  EXPECT_OK(write_png(pixels, 7, 3, &png));
+
+  const unsigned char signature[] = {137, 80, 78, 71, 13, 10, 26, 10};
+  EXPECT(png.size() > 33);
+  EXPECT(memcmp(png.data(), signature, sizeof(signature)) == 0);
+  EXPECT_EQ(read_uint32_be(png, 8), 13);
+  EXPECT_EQ(png.substr(12, 4), "IHDR");
+  EXPECT_EQ(read_uint32_be(png, 16), 7);
+  EXPECT_EQ(read_uint32_be(png, 20), 3);
+  EXPECT_EQ(uint8_t(png[24]), 8);
+  EXPECT_EQ(uint8_t(png[25]), PNG_COLOR_TYPE_RGB_ALPHA);
+}
+
+void test_png_roundtrip() {
+  std::vector<uint32_t> pixels = {
+    0xffff0000, 0xff00ff00, 0xff0000ff,
+    0x00000000, 0x80800000, 0xffffffff,
+  };
+
+  std::string png;
+  EXPECT_OK(write_png(pixels, 3, 2, &png));
+
+  png_image image;
+  memset(&image, 0, sizeof(image));
+  image.version = PNG_IMAGE_VERSION;
+  EXPECT(png_image_begin_read_from_memory(&image, png.data(), png.size()));
+  EXPECT_EQ(image.width, 3);
+  EXPECT_EQ(image.height, 2);
+
+  image.format = PNG_FORMAT_RGBA;
+  std::vector<uint8_t> rgba(PNG_IMAGE_SIZE(image));
+  EXPECT(png_image_finish_read(&image, nullptr, rgba.data(), 0, nullptr));
+
+  const uint8_t expected[] = {
+    0xff, 0x00, 0x00, 0xff,   0x00, 0xff, 0x00, 0xff,   0x00, 0x00, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00,   0xff, 0x00, 0x00, 0x80,   0xff, 0xff, 0xff, 0xff,
+  };
+
+  EXPECT_EQ(rgba.size(), sizeof(expected));
+  EXPECT(memcmp(rgba.data(), expected, sizeof(expected)) == 0);
+}
+
+void test_png_write_error() {
+  std::vector<uint32_t> pixels(4 * 4, 0xff000000);
+
+  auto rc = png_write_argb32(
+      reinterpret_cast<const unsigned char*>(pixels.data()),
+      4,
+      4,
+      4 * sizeof(uint32_t),
+      [] (const char*, size_t) -> ReturnCode {
+        return error(ERROR, "write failed");
+      });
+
+  EXPECT(!rc);
+  EXPECT_STREQ(rc.message, "write failed");
+}
+
+void test_png_export_degenerate_path() {
+  Context ctx;
+  ctx.width = from_px(4);
+  ctx.height = from_px(4);
+
+  Path rect;
+  rect.moveTo(0, 0);
+  rect.lineTo(4, 0);
+  rect.lineTo(4, 4);
+  rect.lineTo(0, 4);
+  rect.closePath();
+
+  FillStyle rect_fill;
+  rect_fill.color = Color::fromRGB(1, 0, 0);
+  draw_path(&ctx, rect, StrokeStyle{}, rect_fill);
+
+  // a line with a single point only consists of a move-to command
+  Path point;
+  point.moveTo(2, 2);
+
+  StrokeStyle point_stroke;
+  point_stroke.line_width = from_px(2);
+  draw_path(&ctx, point, point_stroke, FillStyle{});
+
+  std::string png;
+  EXPECT_OK(export_png(&ctx, &png));
+
+  png_image image;
+  memset(&image, 0, sizeof(image));
+  image.version = PNG_IMAGE_VERSION;
+  EXPECT(png_image_begin_read_from_memory(&image, png.data(), png.size()));
+  EXPECT_EQ(image.width, 4);
+  EXPECT_EQ(image.height, 4);
+
+  image.format = PNG_FORMAT_RGBA;
+  std::vector<uint8_t> rgba(PNG_IMAGE_SIZE(image));
+  EXPECT(png_image_finish_read(&image, nullptr, rgba.data(), 0, nullptr));
+
+  for (size_t i = 0; i < rgba.size(); i += 4) {
+    EXPECT_EQ(rgba[i + 0], 0xff);
+    EXPECT_EQ(rgba[i + 1], 0x00);
+    EXPECT_EQ(rgba[i + 2], 0x00);
+    EXPECT_EQ(rgba[i + 3], 0xff);
+  }
+}
+
+int main(int argc, char** argv) {
+  test_png_header();
+  test_png_roundtrip();
+  test_png_write_error();
+  test_png_export_degenerate_path();
+}
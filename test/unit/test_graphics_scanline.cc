@@ -0,0 +1,254 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include "graphics/path.h"
+#include "graphics/scanline.h"
+#include "unittest.h"
+
+using namespace clip;
+
+/**
+ * A transparent ARGB32 canvas; shapes are drawn in opaque black so that the
+ * alpha channel of each pixel is its coverage
+ */
+struct TestCanvas {
+  TestCanvas(uint32_t w, uint32_t h) : width(w), height(h), pixels(w * h, 0) {
+    target.data = reinterpret_cast<unsigned char*>(pixels.data());
+    target.width = width;
+    target.height = height;
+    target.stride = width * sizeof(uint32_t);
+    target.format = ScanlinePixelFormat::ARGB32_PREMULTIPLIED;
+  }
+
+  uint32_t alpha(uint32_t x, uint32_t y) const {
+    return pixels[y * width + x] >> 24;
+  }
+
+  uint32_t width;
+  uint32_t height;
+  std::vector<uint32_t> pixels;
+  ScanlineTarget target;
+  ScanlineRasterizer rasterizer;
+};
+
+void add_rectangle(Path* path, double x0, double y0, double x1, double y1) {
+  path->moveTo(x0, y0);
+  path->lineTo(x1, y0);
+  path->lineTo(x1, y1);
+  path->lineTo(x0, y1);
+  path->closePath();
+}
+
+void fill(TestCanvas* canvas, const Path& path) {
+  EXPECT_OK(
+      scanline_fill_path(
+          &canvas->rasterizer,
+          canvas->target,
+          path,
+          Color::fromRGB(0, 0, 0),
+          std::nullopt));
+}
+
+void stroke(TestCanvas* canvas, const Path& path, double line_width) {
+  StrokeStyle style;
+  style.line_width = from_px(line_width);
+  style.color = Color::fromRGB(0, 0, 0);
+
+  EXPECT_OK(
+      scanline_stroke_path(
+          &canvas->rasterizer,
+          canvas->target,
+          path,
+          style,
+          std::nullopt));
+}
+
+double point_segment_distance(vec2 p, vec2 a, vec2 b) {
+  auto ab = sub(b, a);
+  auto t = std::clamp(dot(sub(p, a), ab) / dot(ab, ab), 0.0, 1.0);
+  return magnitude(sub(p, add(a, mul(ab, t))));
+}
+
+vec2 cubic_point(vec2 p0, vec2 p1, vec2 p2, vec2 p3, double t) {
+  auto s = 1 - t;
+  return add(
+      add(mul(p0, s * s * s), mul(p1, 3 * s * s * t)),
+      add(mul(p2, 3 * s * t * t), mul(p3, t * t * t)));
+}
+
+void test_flatten_tolerance() {
+  vec2 p0(0, 0);
+  vec2 p1(0, 55.23);
+  vec2 p2(44.77, 100);
+  vec2 p3(100, 100);
+
+  Path path;
+  path.moveTo(p0.x, p0.y);
+  path.cubicCurveTo(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y);
+
+  size_t vertex_count_prev = 0;
+  for (auto tolerance : {1.0, 0.1, 0.01}) {
+    std::vector<PathPolyline> polylines;
+    path_flatten(path, tolerance, &polylines);
+    EXPECT_EQ(polylines.size(), 1);
+
+    const auto& vertices = polylines[0].vertices;
+    EXPECT(!polylines[0].closed);
+    EXPECT(vertices.size() > vertex_count_prev);
+    EXPECT_FEQ(vertices.front().x, p0.x);
+    EXPECT_FEQ(vertices.front().y, p0.y);
+    EXPECT_FEQ(vertices.back().x, p3.x);
+    EXPECT_FEQ(vertices.back().y, p3.y);
+
+    // every point on the curve is within the tolerance of the polyline
+    for (size_t i = 0; i <= 1000; ++i) {
+      auto p = cubic_point(p0, p1, p2, p3, i / 1000.0);
+
+      auto distance = std::numeric_limits<double>::infinity();
+      for (size_t j = 1; j < vertices.size(); ++j) {
+        distance = std::min(
+            distance,
+            point_segment_distance(p, vertices[j - 1], vertices[j]));
+      }
+
+      EXPECT(distance <= tolerance);
+    }
+
+    vertex_count_prev = vertices.size();
+  }
+}
+
+void test_fill_rectangle_full_coverage() {
+  TestCanvas canvas(16, 16);
+
+  Path path;
+  add_rectangle(&path, 4, 2, 12, 10);
+  fill(&canvas, path);
+
+  for (uint32_t y = 0; y < canvas.height; ++y) {
+    for (uint32_t x = 0; x < canvas.width; ++x) {
+      auto inside = x >= 4 && x < 12 && y >= 2 && y < 10;
+      EXPECT_EQ(canvas.alpha(x, y), inside ? 255 : 0);
+    }
+  }
+}
+
+void test_fill_rectangle_half_coverage() {
+  TestCanvas canvas(16, 16);
+
+  Path path;
+  add_rectangle(&path, 4, 2, 11.5, 10);
+  fill(&canvas, path);
+
+  for (uint32_t y = 2; y < 10; ++y) {
+    EXPECT_EQ(canvas.alpha(10, y), 255);
+    EXPECT(canvas.alpha(11, y) >= 127 && canvas.alpha(11, y) <= 128);
+    EXPECT_EQ(canvas.alpha(12, y), 0);
+  }
+
+  // the top edge covers a quarter of the pixels in the first row
+  TestCanvas canvas_top(16, 16);
+
+  Path path_top;
+  add_rectangle(&path_top, 4, 1.75, 12, 10);
+  fill(&canvas_top, path_top);
+
+  EXPECT(canvas_top.alpha(8, 1) >= 63 && canvas_top.alpha(8, 1) <= 64);
+  EXPECT_EQ(canvas_top.alpha(8, 2), 255);
+}
+
+void test_fill_nonzero_winding() {
+  // two overlapping subpaths with the same orientation: the overlap has a
+  // winding number of two and is filled (the even-odd rule would leave it
+  // empty)
+  {
+    TestCanvas canvas(16, 16);
+
+    Path path;
+    add_rectangle(&path, 2, 2, 10, 10);
+    add_rectangle(&path, 6, 6, 14, 14);
+    fill(&canvas, path);
+
+    EXPECT_EQ(canvas.alpha(4, 4), 255);
+    EXPECT_EQ(canvas.alpha(8, 8), 255);
+    EXPECT_EQ(canvas.alpha(12, 12), 255);
+    EXPECT_EQ(canvas.alpha(12, 4), 0);
+  }
+
+  // an inner subpath with the opposite orientation cuts a hole
+  {
+    TestCanvas canvas(16, 16);
+
+    Path path;
+    add_rectangle(&path, 2, 2, 14, 14);
+    path.moveTo(6, 6);
+    path.lineTo(6, 10);
+    path.lineTo(10, 10);
+    path.lineTo(10, 6);
+    path.closePath();
+    fill(&canvas, path);
+
+    EXPECT_EQ(canvas.alpha(4, 4), 255);
+    EXPECT_EQ(canvas.alpha(8, 8), 0);
+    EXPECT_EQ(canvas.alpha(12, 12), 255);
+  }
+}
+
+void test_stroke_miter_limit() {
+  // a right angle is joined with a miter that fills the outer corner
+  {
+    TestCanvas canvas(64, 64);
+
+    Path path;
+    path.moveTo(10, 10);
+    path.lineTo(50, 10);
+    path.lineTo(50, 50);
+    stroke(&canvas, path, 10);
+
+    EXPECT_EQ(canvas.alpha(54, 5), 255);
+    EXPECT_EQ(canvas.alpha(30, 10), 255);
+    EXPECT_EQ(canvas.alpha(50, 30), 255);
+  }
+
+  // the miter of this sharp angle would be about sixteen times as long as the
+  // line width, so it is replaced by a bevel that ends at the vertex
+  {
+    TestCanvas canvas(140, 100);
+
+    Path path;
+    path.moveTo(10, 45);
+    path.lineTo(90, 50);
+    path.lineTo(10, 55);
+    stroke(&canvas, path, 4);
+
+    EXPECT_EQ(canvas.alpha(50, 47), 255);
+    EXPECT_EQ(canvas.alpha(50, 52), 255);
+
+    for (uint32_t x = 91; x < canvas.width; ++x) {
+      for (uint32_t y = 0; y < canvas.height; ++y) {
+        EXPECT_EQ(canvas.alpha(x, y), 0);
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  test_flatten_tolerance();
+  test_fill_rectangle_full_coverage();
+  test_fill_rectangle_half_coverage();
+  test_fill_nonzero_winding();
+  test_stroke_miter_limit();
+}
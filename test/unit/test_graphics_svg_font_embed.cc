@@ -0,0 +1,105 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "context.h"
+#include "eval.h"
+#include "graphics/export_svg.h"
+#include "unittest.h"
+
+using namespace clip;
+
+size_t count_substr(const std::string& str, const std::string& substr) {
+  size_t count = 0;
+  for (auto pos = str.find(substr);
+       pos != std::string::npos;
+       pos = str.find(substr, pos + substr.size())) {
+    ++count;
+  }
+
+  return count;
+}
+
+void test_font_embed_legend() {
+  Context ctx;
+  ctx.font_defaults = false;
+  ctx.font_load = {test_data_path("fonts/LiberationSans-Regular.ttf")};
+  EXPECT_OK(context_setup_defaults(&ctx));
+
+  EXPECT_OK(
+      eval(
+          &ctx,
+          "(set-width 400px)"
+          "(set-height 80px)"
+          "(set-font-embed on)"
+          "(figure/draw-legend"
+          "    item (label \"Fnord Test\" color #06c)"
+          "    item (label \"Another Test\" color #c06))"));
+
+  std::string svg;
+  EXPECT_OK(export_svg(&ctx, &svg));
+
+  // both labels use the same font, so exactly one subset is embedded
+  EXPECT_EQ(count_substr(svg, "@font-face"), 1);
+
+  const std::string font_face =
+      "@font-face { "
+      "font-family: \"clip-font-0\"; "
+      "src: url(data:font/ttf;base64,";
+
+  auto font_data_begin = svg.find(font_face);
+  EXPECT(font_data_begin != std::string::npos);
+  font_data_begin += font_face.size();
+
+  auto font_data_end = svg.find("); }", font_data_begin);
+  EXPECT(font_data_end != std::string::npos);
+  EXPECT(font_data_end > font_data_begin);
+  EXPECT_EQ((font_data_end - font_data_begin) % 4, 0);
+
+  auto font_data = svg.substr(font_data_begin, font_data_end - font_data_begin);
+  auto font_data_padding = font_data.find_first_of('=');
+  EXPECT(
+      font_data.find_first_not_of(
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/") ==
+      font_data_padding);
+  EXPECT(
+      font_data_padding == std::string::npos ||
+      font_data.find_first_not_of('=', font_data_padding) == std::string::npos);
+
+  // the labels are written as text instead of glyph outlines
+  EXPECT_EQ(count_substr(svg, "<text"), 2);
+  EXPECT_EQ(count_substr(svg, "font-family=\"clip-font-0\">Fnord Test</text>"), 1);
+  EXPECT_EQ(count_substr(svg, "font-family=\"clip-font-0\">Another Test</text>"), 1);
+}
+
+void test_font_embed_disabled() {
+  Context ctx;
+  ctx.font_defaults = false;
+  ctx.font_load = {test_data_path("fonts/LiberationSans-Regular.ttf")};
+  EXPECT_OK(context_setup_defaults(&ctx));
+
+  EXPECT_OK(
+      eval(
+          &ctx,
+          "(figure/draw-legend"
+          "    item (label \"Fnord Test\" color #06c))"));
+
+  std::string svg;
+  EXPECT_OK(export_svg(&ctx, &svg));
+  EXPECT_EQ(count_substr(svg, "@font-face"), 0);
+  EXPECT_EQ(count_substr(svg, "<text"), 0);
+}
+
+int main(int argc, char** argv) {
+  test_font_embed_legend();
+  test_font_embed_disabled();
+}
@@ -0,0 +1,154 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include "graphics/text_backend.h"
+#include "graphics/text_support.h"
+#include "unittest.h"
+
+using namespace clip;
+using namespace clip::text;
+
+// directional marks and formatting characters in UTF-8
+#define kLRM "\xE2\x80\x8E"
+#define kRLM "\xE2\x80\x8F"
+#define kLRE "\xE2\x80\xAA"
+#define kPDF "\xE2\x80\xAC"
+#define kRLO "\xE2\x80\xAE"
+#define kRLI "\xE2\x81\xA7"
+#define kFSI "\xE2\x81\xA8"
+#define kPDI "\xE2\x81\xA9"
+
+TextLine make_line(const std::string& text, TextDirection base_direction) {
+  TextSpan span;
+  span.text = text;
+  span.text_direction = base_direction;
+  span.font_size = 12;
+  span.span_id = 0;
+
+  TextLine line;
+  line.base_direction = base_direction;
+  line.spans.push_back(span);
+  return line;
+}
+
+void test_ltr_only_ascii() {
+  EXPECT(text_is_ltr_only(""));
+  EXPECT(text_is_ltr_only("Hello World 123"));
+  EXPECT(text_is_ltr_only("(a + b) * c = 42%"));
+}
+
+void test_ltr_only_non_ascii() {
+  EXPECT(text_is_ltr_only("Café Zürich"));
+  EXPECT(text_is_ltr_only("Ελληνικά"));
+  EXPECT(text_is_ltr_only("東京 123"));
+  EXPECT(text_is_ltr_only("€ 12,50"));
+  EXPECT(text_is_ltr_only("abc" kLRM "def"));
+}
+
+void test_ltr_only_rtl_text() {
+  EXPECT(!text_is_ltr_only("שלום"));
+  EXPECT(!text_is_ltr_only("hello שלום world"));
+  EXPECT(!text_is_ltr_only("مرحبا"));
+}
+
+void test_ltr_only_directional_formatting() {
+  EXPECT(!text_is_ltr_only("abc" kRLM "def"));
+  EXPECT(!text_is_ltr_only("abc" kLRE "def" kPDF));
+  EXPECT(!text_is_ltr_only("abc" kRLO "def" kPDF));
+  EXPECT(!text_is_ltr_only("abc" kRLI "def" kPDI));
+  EXPECT(!text_is_ltr_only("abc" kFSI "def" kPDI));
+}
+
+void test_ltr_only_malformed_utf8() {
+  EXPECT(!text_is_ltr_only("abc\xC3"));
+  EXPECT(!text_is_ltr_only("abc\xE6\x9D"));
+  EXPECT(!text_is_ltr_only("\xF0\x9F\x98"));
+}
+
+void test_reorder_ltr_fast_path() {
+  auto line = make_line("Café 東京", TextDirection::LTR);
+  EXPECT_OK(text_reorder_bidi_line(&line));
+
+  EXPECT_EQ(line.spans.size(), 1);
+  EXPECT_EQ(line.spans[0].text, "Café 東京");
+  EXPECT(line.spans[0].text_direction == TextDirection::LTR);
+}
+
+#if CLIP_TEXT_ENABLE_BIDI == 1
+void expect_reorder_matches_bidi(const std::string& text) {
+  auto line = make_line(text, TextDirection::LTR);
+  EXPECT_OK(text_reorder_bidi_line(&line));
+
+  auto line_ref = make_line(text, TextDirection::LTR);
+  std::vector<TextSpan> runs;
+  std::vector<int> run_levels;
+  EXPECT_OK(
+      text_analyze_bidi_line(
+          &*line_ref.spans.begin(),
+          &*line_ref.spans.end(),
+          line_ref.base_direction,
+          &runs,
+          &run_levels));
+
+  EXPECT_EQ(line.spans.size(), runs.size());
+  for (size_t i = 0; i < runs.size(); ++i) {
+    EXPECT_EQ(line.spans[i].text, runs[i].text);
+    EXPECT(line.spans[i].text_direction == runs[i].text_direction);
+  }
+}
+
+void test_reorder_matches_bidi() {
+  expect_reorder_matches_bidi("Hello World");
+  expect_reorder_matches_bidi("Café Zürich");
+  expect_reorder_matches_bidi("東京 123");
+}
+
+void test_reorder_mixed() {
+  auto line = make_line("abc שלום def", TextDirection::LTR);
+  EXPECT_OK(text_reorder_bidi_line(&line));
+
+  EXPECT_EQ(line.spans.size(), 3);
+  EXPECT_EQ(line.spans[0].text, "abc ");
+  EXPECT(line.spans[0].text_direction == TextDirection::LTR);
+  EXPECT_EQ(line.spans[1].text, "שלום");
+  EXPECT(line.spans[1].text_direction == TextDirection::RTL);
+  EXPECT_EQ(line.spans[2].text, " def");
+  EXPECT(line.spans[2].text_direction == TextDirection::LTR);
+}
+
+void test_reorder_rlm() {
+  auto line = make_line("abc" kRLM, TextDirection::LTR);
+  EXPECT_OK(text_reorder_bidi_line(&line));
+
+  // the mark is kept in a right-to-left run of its own
+  EXPECT_EQ(line.spans.size(), 2);
+  EXPECT_EQ(line.spans[0].text, "abc");
+  EXPECT_EQ(line.spans[1].text, kRLM);
+  EXPECT(line.spans[1].text_direction == TextDirection::RTL);
+}
+#endif
+
+int main(int argc, char** argv) {
+  test_ltr_only_ascii();
+  test_ltr_only_non_ascii();
+  test_ltr_only_rtl_text();
+  test_ltr_only_directional_formatting();
+  test_ltr_only_malformed_utf8();
+  test_reorder_ltr_fast_path();
+#if CLIP_TEXT_ENABLE_BIDI == 1
+  test_reorder_matches_bidi();
+  test_reorder_mixed();
+  test_reorder_rlm();
+#endif
+}
@@ -0,0 +1,38 @@
+/**
+ * This file is part of the "clip" project
+ *   Copyright (c) 2018 Paul Asmuth
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include "utils/stringutil.h"
+#include "unittest.h"
+
+using namespace clip;
+
+void test_base64_encode() {
+  EXPECT_EQ(StringUtil::base64Encode("", 0), "");
+  EXPECT_EQ(StringUtil::base64Encode("c", 1), "Yw==");
+  EXPECT_EQ(StringUtil::base64Encode("cl", 2), "Y2w=");
+  EXPECT_EQ(StringUtil::base64Encode("cli", 3), "Y2xp");
+  EXPECT_EQ(StringUtil::base64Encode("clip", 4), "Y2xpcA==");
+  EXPECT_EQ(StringUtil::base64Encode("clip!", 5), "Y2xpcCE=");
+  EXPECT_EQ(StringUtil::base64Encode("clip!?", 6), "Y2xpcCE/");
+}
+
+void test_base64_encode_binary() {
+  const unsigned char data[] = {0x00, 0xff, 0xfe, 0x7f, 0x80};
+  EXPECT_EQ(StringUtil::base64Encode(data, sizeof(data)), "AP/+f4A=");
+}
+
+int main(int argc, char** argv) {
+  test_base64_encode();
+  test_base64_encode_binary();
+}